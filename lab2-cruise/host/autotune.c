@@ -0,0 +1,321 @@
+/* Parallel autotuner of the cruise controller gains
+ *
+ * Description:
+ *
+ *   Runs the closed loop of closed_loop.c (vehicle model and control law of
+ *   ControlTask) for every candidate of a grid of gains over a set of
+ *   standard scenarios, spread over all cores, and writes the candidates
+ *   that are Pareto-best in settling time, overshoot and throttle effort as
+ *   the header src/cruise_gains.h.
+ *
+ *   usage: autotune [-d kd grid] [-f lookahead ms] [-i ti grid] [-j threads]
+ *                   [-k kp*period grid] [-o header] [-p period ms]
+ *
+ *   A grid is 'min:max:points', linear; kp * period and kd in s, ti in ms.
+ *   -f tunes with the gradient feedforward (cruise_control.h) like
+ *   ControlTask with FEEDFORWARD; -p is the control period, CONTROL_PERIOD
+ *   by default.
+ *
+ *   Standard scenarios: the car accelerates with the gas pedal to 5 m/s
+ *   above the engage speed, coasts and engages cruise mode at the engage
+ *   speed (30, 40, 55 m/s), starting on the flat, on the uphill, on the
+ *   steep uphill and on the downhill of the track, then cruises for 120 s.
+ *   Per candidate:
+ *
+ *     settling   mean settling time of all scenarios, see closed_loop.h
+ *     overshoot  largest overshoot of all scenarios
+ *     effort     mean sum of throttle changes while cruising
+ *
+ *   A candidate that does not settle in every scenario is rejected. Of the
+ *   Pareto set, the header selects the one with the smallest sum of the
+ *   three objectives, each scaled to the range it spans in the set.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "closed_loop.h"
+#include "cruise_tasks.h"
+
+#define SCENARIOS 12
+
+static const int engage_speed[3] = {30, 40, 55};       /* [m/s] */
+static const INT32U start[4] = {0, 400, 800, 1600};     /* [m] */
+
+typedef struct {
+  double min, max;
+  int    points;
+} grid;
+
+typedef struct {
+  double kp_period, ti, kd;  /* kp * period [s], [ms], [s] */
+  int    valid;
+  double settling, overshoot, effort, rms;
+  int    pareto;
+} candidate;
+
+typedef struct {
+  candidate      *c;
+  int             count;
+  int             next;
+  INT16U          period;
+  int             lookahead;
+  pthread_mutex_t lock;
+} tune_batch;
+
+static double grid_value(const grid *g, int i)
+{
+  return g->points > 1 ? g->min + (g->max - g->min) * i / (g->points - 1) : g->min;
+}
+
+static int parse_grid(const char *s, grid *g)
+{
+  return sscanf(s, "%lf:%lf:%d", &g->min, &g->max, &g->points) == 3 && g->points > 0
+      && g->min <= g->max ? 0 : -1;
+}
+
+/* Returns the sum of throttle changes while cruising */
+static double run_scenario(const tune_batch *b, const candidate *c, int s, cl_metrics *m)
+{
+  closed_loop cl;
+  cl_inputs in;
+  int engage = engage_speed[s % 3];
+  INT32U end = 0;
+  INT8U prev = 0;
+  double effort = 0;
+
+  cl_init(&cl, b->period, 0);
+  cruise_ctl_set_gains(&cl.control, PID_FIX(c->kp_period), (INT16U)c->ti, PID_FIX(c->kd));
+  if (b->lookahead >= 0)
+    cruise_ctl_set_feedforward(&cl.control, cl.vehicle.track, (INT16U)b->lookahead);
+  cl.vehicle.position = VM_POS_FROM_INT(start[s / 3]);
+  cl_metrics_init(m);
+  in.driver.engine = on;
+  in.driver.top_gear = on;
+  in.driver.gas_pedal = on;
+  in.driver.cruise_control = off;
+  in.brake = off;
+
+  while (end == 0 || cl.time < end) {
+    if (in.driver.gas_pedal == on && cl.vehicle.velocity >= VM_FROM_INT(engage + 5))
+      in.driver.gas_pedal = off;
+    if (in.driver.gas_pedal == off && in.driver.cruise_control == off
+        && cl.vehicle.velocity <= VM_FROM_INT(engage)) {
+      in.driver.cruise_control = on;
+      end = cl.time + 120000;
+    }
+    cl_step(&cl, &in);
+    cl_metrics_add(m, &cl);
+    if (cl.control.cruising)
+      effort += abs((int)cl.throttle[0] - (int)prev);
+    prev = cl.throttle[0];
+    if (cl.time > 600000)
+      break;
+  }
+  return effort;
+}
+
+static void evaluate(const tune_batch *b, candidate *c)
+{
+  cl_metrics m;
+  double effort;
+  int s;
+
+  c->valid = 1;
+  c->settling = c->overshoot = c->effort = c->rms = 0;
+  for (s = 0; s < SCENARIOS; s++) {
+    effort = run_scenario(b, c, s, &m);
+    if (cl_settling_time(&m) < 0) {
+      c->valid = 0;
+      return;
+    }
+    c->settling += cl_settling_time(&m) / SCENARIOS;
+    c->effort += effort / SCENARIOS;
+    c->rms += cl_rms_error(&m) / SCENARIOS;
+    if (m.overshoot > c->overshoot)
+      c->overshoot = m.overshoot;
+  }
+}
+
+static void *worker(void *arg)
+{
+  tune_batch *b = arg;
+  int index;
+
+  while (1) {
+    pthread_mutex_lock(&b->lock);
+    index = b->next++;
+    pthread_mutex_unlock(&b->lock);
+    if (index >= b->count)
+      break;
+    evaluate(b, &b->c[index]);
+  }
+  return NULL;
+}
+
+static int dominates(const candidate *a, const candidate *b)
+{
+  return a->settling <= b->settling && a->overshoot <= b->overshoot && a->effort <= b->effort
+      && (a->settling < b->settling || a->overshoot < b->overshoot || a->effort < b->effort);
+}
+
+static int by_settling(const void *a, const void *b)
+{
+  const candidate *x = a, *y = b;
+
+  return x->settling < y->settling ? -1 : x->settling > y->settling;
+}
+
+/* Moves the Pareto set to the front of 'c', sorted by settling time, returns its size */
+static int pareto_set(candidate *c, int count)
+{
+  candidate tmp;
+  int i, j, n = 0;
+
+  for (i = 0; i < count; i++) {
+    c[i].pareto = c[i].valid;
+    for (j = 0; j < count && c[i].pareto; j++)
+      if (c[j].valid && dominates(&c[j], &c[i]))
+        c[i].pareto = 0;
+  }
+  for (i = 0; i < count; i++) {
+    if (c[i].pareto) {
+      tmp = c[n];
+      c[n++] = c[i];
+      c[i] = tmp;
+    }
+  }
+  qsort(c, n, sizeof(candidate), by_settling);
+  return n;
+}
+
+static double scaled(double x, double lo, double hi)
+{
+  return hi > lo ? (x - lo) / (hi - lo) : 0;
+}
+
+static int select_balanced(const candidate *c, int n)
+{
+  double lo[3] = {1e30, 1e30, 1e30}, hi[3] = {-1e30, -1e30, -1e30}, v[3], score, best = 1e30;
+  int i, k, selected = 0;
+
+  for (i = 0; i < n; i++) {
+    v[0] = c[i].settling; v[1] = c[i].overshoot; v[2] = c[i].effort;
+    for (k = 0; k < 3; k++) {
+      if (v[k] < lo[k]) lo[k] = v[k];
+      if (v[k] > hi[k]) hi[k] = v[k];
+    }
+  }
+  for (i = 0; i < n; i++) {
+    score = scaled(c[i].settling, lo[0], hi[0]) + scaled(c[i].overshoot, lo[1], hi[1])
+          + scaled(c[i].effort, lo[2], hi[2]);
+    if (score < best) {
+      best = score;
+      selected = i;
+    }
+  }
+  return selected;
+}
+
+static void write_header(FILE *f, const candidate *c, int n, int selected, int argc, char **argv)
+{
+  int i;
+
+  fprintf(f, "/* Gains of the cruise controller\n *\n * Generated by host/autotune");
+  for (i = 1; i < argc; i++)
+    fprintf(f, " %s", argv[i]);
+  fprintf(f, ", do not edit.\n *\n"
+      " * CRUISE_GAIN_SETS lists the Pareto-best candidates over the standard\n"
+      " * scenarios of autotune.c, by settling time; CRUISE_KP_PERIOD, CRUISE_TI\n"
+      " * and CRUISE_KD are the balanced one of them.\n"
+      " *\n"
+      " * X(kp * period [s], ti [ms], kd [s], settling [s], overshoot [m/s], effort, rms error [m/s])\n"
+      " */\n");
+  fprintf(f, "#ifndef CRUISE_GAINS_H\n#define CRUISE_GAINS_H\n\n#include \"cruise_pid.h\"\n\n");
+  fprintf(f, "#define CRUISE_GAIN_SETS(X) \\\n");
+  for (i = 0; i < n; i++)
+    fprintf(f, "  X(%.3f, %4.0f, %.3f, %5.2f, %.3f, %5.0f, %.4f)%s\n", c[i].kp_period, c[i].ti,
+        c[i].kd, c[i].settling, c[i].overshoot, c[i].effort, c[i].rms, i + 1 < n ? " \\" : "");
+  fprintf(f, "\n#define CRUISE_KP_PERIOD PID_FIX(%.3f) /* kp * period [s] */\n", c[selected].kp_period);
+  fprintf(f, "#define CRUISE_TI        %-12.0f /* integral time [ms] */\n", c[selected].ti);
+  fprintf(f, "#define CRUISE_KD        PID_FIX(%.3f) /* [s] */\n", c[selected].kd);
+  fprintf(f, "\n#endif /* CRUISE_GAINS_H */\n");
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-d kd grid] [-f lookahead ms] [-i ti grid] [-j threads] "
+      "[-k kp*period grid] [-o header] [-p period ms]\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  grid kp = {0.1, 1.5, 15}, ti = {250, 4000, 16}, kd = {0, 0.2, 5};
+  tune_batch b;
+  const char *path = NULL;
+  pthread_t *tid;
+  FILE *f = stdout;
+  int threads, period = CONTROL_PERIOD, i, j, k, n, opt, selected;
+
+  memset(&b, 0, sizeof(b));
+  b.lookahead = -1;
+  threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc, argv, "d:f:i:j:k:o:p:")) != -1) {
+    switch (opt) {
+    case 'd': if (parse_grid(optarg, &kd) < 0) usage(argv[0]); break;
+    case 'f': b.lookahead = atoi(optarg); break;
+    case 'i': if (parse_grid(optarg, &ti) < 0) usage(argv[0]); break;
+    case 'j': threads = atoi(optarg); break;
+    case 'k': if (parse_grid(optarg, &kp) < 0) usage(argv[0]); break;
+    case 'o': path = optarg; break;
+    case 'p': period = atoi(optarg); break;
+    default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || threads < 1 || period < 1 || period > 65535 || ti.min < 1 || ti.max > 65535)
+    usage(argv[0]);
+  b.period = (INT16U)period;
+
+  b.count = kp.points * ti.points * kd.points;
+  b.c = calloc(b.count, sizeof(candidate));
+  for (i = 0, n = 0; i < kp.points; i++)
+    for (j = 0; j < ti.points; j++)
+      for (k = 0; k < kd.points; k++, n++) {
+        b.c[n].kp_period = grid_value(&kp, i);
+        b.c[n].ti = (INT16U)(grid_value(&ti, j) + 0.5);
+        b.c[n].kd = grid_value(&kd, k);
+      }
+  pthread_mutex_init(&b.lock, NULL);
+  tid = malloc(threads * sizeof(pthread_t));
+  for (i = 0; i < threads; i++)
+    pthread_create(&tid[i], NULL, worker, &b);
+  for (i = 0; i < threads; i++)
+    pthread_join(tid[i], NULL);
+
+  for (i = 0, k = 0; i < b.count; i++)
+    k += b.c[i].valid;
+  n = pareto_set(b.c, b.count);
+  fprintf(stderr, "%d candidates x %d scenarios on %d threads, %d settle, %d Pareto-best\n",
+      b.count, SCENARIOS, threads, k, n);
+  if (n == 0) {
+    fprintf(stderr, "no candidate settles in every scenario\n");
+    return 1;
+  }
+  selected = select_balanced(b.c, n);
+  fprintf(stderr, "selected kp*period %.3f s, ti %.0f ms, kd %.3f s: settling %.2f s, "
+      "overshoot %.3f m/s, effort %.0f\n", b.c[selected].kp_period, b.c[selected].ti,
+      b.c[selected].kd, b.c[selected].settling, b.c[selected].overshoot, b.c[selected].effort);
+
+  if (path && (f = fopen(path, "w")) == NULL) {
+    perror(path);
+    return 1;
+  }
+  write_header(f, b.c, n, selected, argc, argv);
+  if (f != stdout)
+    fclose(f);
+  free(tid);
+  free(b.c);
+  return 0;
+}
@@ -0,0 +1,514 @@
+/* Host-side benchmarks for the cruise control application
+ *
+ * Description:
+ *
+ *   Runs the portable modules of lab2-cruise/src on the host, checks them
+ *   against reference implementations and measures their cost per call.
+ *
+ *   usage: bench vehicle   fixed-point vehicle model vs. double reference
+ *          bench throttle  throttle gain schedules vs. the old linear search
+ *          bench cruise    step response of the cruise controller on the track
+ *          bench rate      fixed vs. adaptive control period, CPU use and error
+ *
+ *   The program exits with a non-zero status if a check fails. Timings are
+ *   host timings; the double precision code runs on a hardware FPU here, so
+ *   on the Nios II the difference is considerably larger (see VEHICLE_PROFILE
+ *   in cruise_skeleton.c for cycle counts on the board).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "vehicle_model.h"
+#include "throttle_table.h"
+#include "closed_loop.h"
+#include "control_rate.h"
+#include "cruise_tasks.h"
+
+#define VEHICLE_PERIOD 300
+#define STEPS          20000
+
+static volatile INT32S sink;
+
+static double now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Deterministic input sequence: throttle changes every 50 steps, the engine
+ * is off for a while and the brake is applied every now and then.
+ */
+static void vehicle_inputs(int k, INT8U *throttle, enum active *engine, enum active *brake)
+{
+  static const INT8U profile[] = {80, 40, 60, 0, 25, 75, 50, 10, 70, 35};
+
+  *throttle = profile[(k / 50) % 10];
+  *engine = (k % 3000) < 2800 ? on : off;
+  *brake = (k % 1000) >= 950 ? on : off;
+}
+
+/*
+ * Double precision reference of the vehicle model
+ */
+typedef struct {
+  double position, velocity;
+} ref_state;
+
+static void ref_step(ref_state *r, INT8U throttle, enum active engine, enum active brake)
+{
+  double dt = VEHICLE_PERIOD / 1000.0;
+  double acceleration;
+
+  if (throttle > VM_MAX_THROTTLE)
+    throttle = VM_MAX_THROTTLE;
+  if (brake == off) {
+    acceleration = -r->velocity;
+    if (engine == on)
+      acceleration += throttle;
+    acceleration += (double)track_slope(&track_loop, (INT32U)r->position) / VM_ONE;
+  } else {
+    acceleration = -4 * r->velocity;
+  }
+  r->position += r->velocity * dt;
+  r->velocity += acceleration * dt;
+  if (r->position >= track_loop.length)
+    r->position -= track_loop.length;
+  else if (r->position < 0)
+    r->position += track_loop.length;
+}
+
+/*
+ * The model as it was computed in VehicleTask before vehicle_model.c:
+ * double arithmetic, velocity truncated to INT16S every step.
+ */
+typedef struct {
+  INT16U position;
+  INT16S velocity;
+} legacy_state;
+
+static void legacy_step(legacy_state *l, INT8U throttle, enum active engine, enum active brake)
+{
+  INT16S acceleration;
+
+  if (throttle > 80) throttle = 80;
+  if (brake == off) {
+    acceleration = -l->velocity;
+    if (engine == on)
+      acceleration += throttle;
+    acceleration += track_slope(&track_loop, l->position) >> VM_FRAC_BITS;
+  } else
+    acceleration = -4 * l->velocity;
+  l->position = l->position + l->velocity * VEHICLE_PERIOD / 1000;
+  l->velocity = l->velocity + acceleration * VEHICLE_PERIOD / 1000.0;
+  if (l->position > 2400)
+    l->position = 0;
+}
+
+static double track_distance(double a, double b)
+{
+  double d = fabs(a - b);
+
+  return d < track_loop.length - d ? d : track_loop.length - d;
+}
+
+static int bench_vehicle(void)
+{
+  vehicle_state vs;
+  ref_state ref = {0, 0};
+  legacy_state legacy = {0, 0};
+  INT8U throttle;
+  enum active engine, brake;
+  double err_v = 0, err_p = 0, legacy_err_v = 0, t0, t_fix, t_legacy;
+  int k, rep;
+
+  vm_init(&vs, VEHICLE_PERIOD);
+  for (k = 0; k < STEPS; k++) {
+    double v, p;
+
+    vehicle_inputs(k, &throttle, &engine, &brake);
+    vm_step(&vs, throttle, engine, brake);
+    ref_step(&ref, throttle, engine, brake);
+    legacy_step(&legacy, throttle, engine, brake);
+
+    v = (double)vs.velocity / VM_ONE;
+    p = (double)vs.position / VM_POS_FROM_INT(1);
+    if (fabs(v - ref.velocity) > err_v)
+      err_v = fabs(v - ref.velocity);
+    if (track_distance(p, ref.position) > err_p)
+      err_p = track_distance(p, ref.position);
+    if (fabs(legacy.velocity - ref.velocity) > legacy_err_v)
+      legacy_err_v = fabs(legacy.velocity - ref.velocity);
+  }
+
+  printf("vehicle: %d steps of %d ms\n", STEPS, VEHICLE_PERIOD);
+  printf("  max velocity error  fixed %.6f m/s   legacy %.3f m/s\n", err_v, legacy_err_v);
+  printf("  max position error  fixed %.6f m\n", err_p);
+
+  t0 = now_ns();
+  for (rep = 0; rep < 50; rep++) {
+    vm_init(&vs, VEHICLE_PERIOD);
+    for (k = 0; k < STEPS; k++) {
+      vehicle_inputs(k, &throttle, &engine, &brake);
+      vm_step(&vs, throttle, engine, brake);
+    }
+    sink = vs.velocity;
+  }
+  t_fix = (now_ns() - t0) / (50.0 * STEPS);
+
+  t0 = now_ns();
+  for (rep = 0; rep < 50; rep++) {
+    legacy.position = 0;
+    legacy.velocity = 0;
+    for (k = 0; k < STEPS; k++) {
+      vehicle_inputs(k, &throttle, &engine, &brake);
+      legacy_step(&legacy, throttle, engine, brake);
+    }
+    sink = legacy.velocity;
+  }
+  t_legacy = (now_ns() - t0) / (50.0 * STEPS);
+  printf("  time per step       fixed %.1f ns   legacy %.1f ns\n", t_fix, t_legacy);
+
+  if (err_v > 0.01 || err_p > 0.5) {
+    printf("vehicle: FAILED, fixed-point model deviates from the reference\n");
+    return 1;
+  }
+  printf("vehicle: ok\n");
+  return 0;
+}
+
+/*
+ * calculate_throttle() as it was before the gain schedules: linear search
+ * and an integer division that makes the interpolation a step function.
+ */
+static int legacy_throttle(int current_velocity, enum active gas_pedal)
+{
+  int i = 0;
+  int throttle = -1; /* undefined outside -5..80 */
+  int velocity_cur[] = {-5, 10, 20, 30, 40, 50, 60, 70, 80};
+  int speed_up[]     = {30, 30, 40, 50, 70, 70, 80, 80, 70};
+  int slow_down[]    = { 5,  5, 10, 20, 30, 40, 50, 60, 70};
+
+  for (; i < 8; i++) {
+    if (velocity_cur[i] <= current_velocity && velocity_cur[i + 1] >= current_velocity) {
+      if (gas_pedal == on) {
+        throttle = (current_velocity - velocity_cur[i]) / (velocity_cur[i + 1] - velocity_cur[i])
+                  * (speed_up[i + 1] - speed_up[i]) + speed_up[i];
+      } else {
+        throttle = (current_velocity - velocity_cur[i]) / (velocity_cur[i + 1] - velocity_cur[i])
+                  * (slow_down[i + 1] - slow_down[i]) + slow_down[i];
+      }
+    }
+  }
+  return throttle;
+}
+
+/* exact value of the schedule, saturated outside of the breakpoints */
+static double ref_throttle(double v, enum active gas_pedal)
+{
+  static const double x[] = {-5, 10, 20, 30, 40, 50, 60, 70, 80};
+  static const double up[] = {30, 30, 40, 50, 70, 70, 80, 80, 70};
+  static const double down[] = { 5,  5, 10, 20, 30, 40, 50, 60, 70};
+  const double *y = (gas_pedal == on) ? up : down;
+  int i;
+
+  if (v <= x[0])
+    return y[0];
+  for (i = 0; i < 8; i++)
+    if (v <= x[i + 1])
+      return y[i] + (y[i + 1] - y[i]) * (v - x[i]) / (x[i + 1] - x[i]);
+  return y[8];
+}
+
+static int bench_throttle(void)
+{
+  double err = 0, legacy_err = 0, t0, t_table, t_legacy;
+  INT32S v, acc = 0;
+  int pedal, rep;
+
+  /* whole and fractional velocities, including values outside the range */
+  for (pedal = 0; pedal < 2; pedal++) {
+    enum active gas = pedal ? on : off;
+    const gain_table *t = pedal ? &throttle_speed_up : &throttle_slow_down;
+
+    for (v = VM_FROM_INT(-20); v <= VM_FROM_INT(100); v += VM_ONE / 16) {
+      double ref = ref_throttle((double)v / VM_ONE, gas);
+      double got = (double)gs_lookup(t, v) / GS_ONE;
+
+      if (fabs(got - ref) > err)
+        err = fabs(got - ref);
+      if ((v & (VM_ONE - 1)) == 0 && v >= VM_FROM_INT(-5) && v <= VM_FROM_INT(80)) {
+        int old = legacy_throttle(v >> VM_FRAC_BITS, gas);
+        if (fabs(old - ref) > legacy_err)
+          legacy_err = fabs(old - ref);
+      }
+    }
+  }
+
+  t0 = now_ns();
+  for (rep = 0; rep < 2000; rep++)
+    for (v = -5; v <= 80; v++)
+      acc += gs_lookup((v & 1) ? &throttle_speed_up : &throttle_slow_down, VM_FROM_INT(v));
+  t_table = (now_ns() - t0) / (2000.0 * 86);
+  sink = acc;
+
+  t0 = now_ns();
+  for (rep = 0; rep < 2000; rep++)
+    for (v = -5; v <= 80; v++)
+      acc += legacy_throttle(v, (v & 1) ? on : off);
+  t_legacy = (now_ns() - t0) / (2000.0 * 86);
+  sink = acc;
+
+  printf("throttle: dense tables of %u entries from %d m/s\n",
+      throttle_speed_up.size, throttle_speed_up.x_min);
+  printf("  max error           table %.4f   legacy %.1f (whole m/s only)\n", err, legacy_err);
+  printf("  time per lookup     table %.1f ns   legacy %.1f ns\n", t_table, t_legacy);
+
+  if (err > 1.0 / 64) {
+    printf("throttle: FAILED, table deviates from the breakpoints\n");
+    return 1;
+  }
+  printf("throttle: ok\n");
+  return 0;
+}
+
+/*
+ * Accelerates with the gas pedal in top gear to 'engage' + 5 m/s, releases
+ * the pedal and engages cruise mode when the car has slowed down to
+ * 'engage' m/s, then cruises over the hills of the track.
+ */
+static void cruise_run(INT16U period, int delay, int engage, cl_metrics *m)
+{
+  closed_loop cl;
+  cl_inputs in;
+
+  cl_init(&cl, period, delay);
+  cl_metrics_init(m);
+  in.driver.engine = on;
+  in.driver.top_gear = on;
+  in.driver.gas_pedal = on;
+  in.driver.cruise_control = off;
+  in.brake = off;
+
+  while (cl.time < 150000) {
+    if (in.driver.gas_pedal == on && cl.vehicle.velocity >= VM_FROM_INT(engage + 5))
+      in.driver.gas_pedal = off;
+    if (in.driver.gas_pedal == off && cl.vehicle.velocity <= VM_FROM_INT(engage))
+      in.driver.cruise_control = on;
+    cl_step(&cl, &in);
+    cl_metrics_add(m, &cl);
+  }
+}
+
+/*
+ * Engages like cruise_run() and, once the velocity has settled, tracks the
+ * target over one lap of the track, from the start of the track to the
+ * start: largest and rms speed deviation. Returns 0 if cruise mode never
+ * settled.
+ */
+static int cruise_lap(INT16U period, int delay, int lookahead, double *max_dev, double *rms)
+{
+  closed_loop cl;
+  cl_inputs in;
+  cl_metrics m;
+  INT32U prev;
+  double e, sq = 0;
+  long n = 0;
+  int lap = 0;
+
+  cl_init(&cl, period, delay);
+  if (lookahead >= 0)
+    cruise_ctl_set_feedforward(&cl.control, cl.vehicle.track, (INT16U)lookahead);
+  cl_metrics_init(&m);
+  in.driver.engine = on;
+  in.driver.top_gear = on;
+  in.driver.gas_pedal = on;
+  in.driver.cruise_control = off;
+  in.brake = off;
+  *max_dev = 0;
+
+  while (lap < 2 && cl.time < 600000) {
+    if (in.driver.gas_pedal == on && cl.vehicle.velocity >= VM_FROM_INT(45))
+      in.driver.gas_pedal = off;
+    if (in.driver.gas_pedal == off && cl.vehicle.velocity <= VM_FROM_INT(40))
+      in.driver.cruise_control = on;
+    prev = vm_position(&cl.vehicle);
+    cl_step(&cl, &in);
+    cl_metrics_add(&m, &cl);
+    if (vm_position(&cl.vehicle) < prev && (lap > 0 || cl_settling_time(&m) >= 0))
+      lap++;
+    if (lap == 1) {
+      e = fabs((double)(cl.vehicle.velocity - cl.control.target) / VM_ONE);
+      if (e > *max_dev)
+        *max_dev = e;
+      sq += e * e;
+      n++;
+    }
+  }
+  *rms = n ? sqrt(sq / n) : 0;
+  return lap == 2;
+}
+
+static int bench_cruise(void)
+{
+  static const INT16U periods[] = {20, 50, 100, 200, 300};
+  cl_metrics m;
+  int i, failed = 0;
+
+  printf("cruise: engage at 40 m/s, 150 s on the track, no hand-over delay\n");
+  printf("  settled: within %.1f m/s for %.0f s; max dev/rms: whole run incl. hills\n", CL_BAND, CL_HOLD);
+  printf("  period  overshoot  settling  max dev   rms err  effort\n");
+  for (i = 0; i < 5; i++) {
+    cruise_run(periods[i], 0, 40, &m);
+    printf("  %4u ms  %5.2f m/s  %6.1f s  %5.2f m/s  %5.3f  %6.0f\n", periods[i],
+        m.overshoot, cl_settling_time(&m), m.max_deviation, cl_rms_error(&m), m.effort);
+    if (!m.engaged || cl_settling_time(&m) < 0 || cl_rms_error(&m) > 1.0)
+      failed = 1;
+  }
+
+  /* the lookahead that fits is the time from the velocity sample to the throttle */
+  printf("cruise: one lap after settling at 40 m/s, without and with gradient feedforward\n");
+  printf("  period  delay  lookahead   max dev  rms err   ff max dev  rms err\n");
+  for (i = 0; i <= 5; i++) {
+    INT16U period = periods[i < 5 ? i : 4];
+    int delay = i < 5 ? 0 : 1;
+    double max_fb, rms_fb, max_ff, rms_ff;
+
+    if (!cruise_lap(period, delay, -1, &max_fb, &rms_fb)
+        || !cruise_lap(period, delay, delay * period, &max_ff, &rms_ff) || max_ff > max_fb)
+      failed = 1;
+    printf("  %4u ms  %5d  %6d ms  %5.2f m/s  %6.3f   %6.2f m/s  %6.3f\n", period, delay,
+        delay * period, max_fb, rms_fb, max_ff, rms_ff);
+  }
+  if (failed) {
+    printf("cruise: FAILED, controller does not hold the target\n");
+    return 1;
+  }
+  printf("cruise: ok\n");
+  return 0;
+}
+
+/* CPU time of a release of ControlTask plus one of VehicleTask [us] */
+#define TASK_BUDGET(name, period, deadline, budget, crit, stack) budget,
+static const long task_budget[TASK_COUNT] = { CRUISE_TASKS(TASK_BUDGET) };
+#undef TASK_BUDGET
+#define LOOP_BUDGET (task_budget[ControlTask_id] + task_budget[VehicleTask_id])
+
+typedef struct {
+  long   steps;
+  double max_error;  /* while cruising [m/s] */
+  double sq_error;   /* time weighted, [m^2/s^2 s] */
+  double cruising;   /* [s] */
+  INT32U changes;
+  INT32U level_ms[RATE_LEVELS];
+} rate_result;
+
+/*
+ * One drive of 260 s on the track: parked for 20 s, then full gas to
+ * 45 m/s, cruise engaged at 40 m/s over the hills, a short brake at 150 s
+ * that cancels it, engaged again at 160 s, engine off at 200 s.
+ */
+static void rate_drive(int adaptive, rate_result *res)
+{
+  closed_loop cl;
+  cl_inputs in;
+  control_rate r;
+  INT16U period = CONTROL_PERIOD, next;
+  double e;
+
+  cl_init(&cl, CONTROL_PERIOD, 0);
+  cruise_ctl_set_feedforward(&cl.control, cl.vehicle.track, 0);
+  rate_init(&r);
+  memset(res, 0, sizeof(*res));
+  in.driver.engine = in.driver.top_gear = in.driver.gas_pedal = off;
+  in.driver.cruise_control = off;
+  in.brake = off;
+
+  while (cl.time < 260000) {
+    in.driver.engine = cl.time >= 20000 && cl.time < 200000 ? on : off;
+    in.driver.top_gear = in.driver.engine;
+    if (cl.time >= 20000 && cl.time < 21000)
+      in.driver.gas_pedal = on;
+    if (in.driver.gas_pedal == on && cl.vehicle.velocity >= VM_FROM_INT(45))
+      in.driver.gas_pedal = off;
+    if (cl.time > 21000 && in.driver.gas_pedal == off && cl.vehicle.velocity <= VM_FROM_INT(40))
+      in.driver.cruise_control = on;
+    in.brake = cl.time >= 150000 && cl.time < 151500 ? on : off;
+    if (cl.time >= 150000 && cl.time < 160000)
+      in.driver.cruise_control = off;
+
+    cl_step(&cl, &in);
+    res->steps++;
+    if (cl.control.cruising) {
+      e = fabs((double)(cl.vehicle.velocity - cl.control.target) / VM_ONE);
+      if (e > res->max_error)
+        res->max_error = e;
+      res->sq_error += e * e * period / 1000.0;
+      res->cruising += period / 1000.0;
+    }
+    if (adaptive) {
+      next = rate_update(&r, &in.driver, in.brake, &cl.control, cl.vehicle.velocity);
+      if (next != period)
+        cl_set_period(&cl, next);
+      period = next;
+    }
+  }
+  res->changes = r.changes;
+  memcpy(res->level_ms, r.level_ms, sizeof(res->level_ms));
+}
+
+static int bench_rate(void)
+{
+  static const INT16U periods[RATE_LEVELS] = RATE_PERIODS;
+  rate_result fixed, adaptive;
+  double cpu_fixed, cpu_adaptive, rms_fixed, rms_adaptive;
+  int i;
+
+  rate_drive(0, &fixed);
+  rate_drive(1, &adaptive);
+  cpu_fixed = fixed.steps * LOOP_BUDGET / 260000.0 / 10;  /* us per ms to percent */
+  cpu_adaptive = adaptive.steps * LOOP_BUDGET / 260000.0 / 10;
+  rms_fixed = fixed.cruising > 0 ? sqrt(fixed.sq_error / fixed.cruising) : 0;
+  rms_adaptive = adaptive.cruising > 0 ? sqrt(adaptive.sq_error / adaptive.cruising) : 0;
+
+  printf("rate: 260 s drive, ControlTask + VehicleTask at their budgets (%ld us per period)\n",
+      LOOP_BUDGET);
+  printf("  mode       releases/s   CPU     rms err   max err  changes\n");
+  printf("  fixed %3u  %9.2f  %5.2f %%  %5.3f m/s  %5.2f m/s  %5u\n", CONTROL_PERIOD,
+      fixed.steps / 260.0, cpu_fixed, rms_fixed, fixed.max_error, 0);
+  printf("  adaptive   %9.2f  %5.2f %%  %5.3f m/s  %5.2f m/s  %5lu\n",
+      adaptive.steps / 260.0, cpu_adaptive, rms_adaptive, adaptive.max_error,
+      (unsigned long)adaptive.changes);
+  printf("  adaptive time per period:");
+  for (i = 0; i < RATE_LEVELS; i++)
+    printf(" %u ms %.0f s", periods[i], adaptive.level_ms[i] / 1000.0);
+  printf("\n");
+  if (cpu_adaptive >= cpu_fixed || rms_adaptive > rms_fixed * 1.1) {
+    printf("rate: FAILED, the adaptive rate costs more CPU or tracks worse\n");
+    return 1;
+  }
+  printf("rate: ok\n");
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s vehicle|throttle|cruise|rate\n", argv[0]);
+    return 2;
+  }
+  if (strcmp(argv[1], "vehicle") == 0)
+    return bench_vehicle();
+  if (strcmp(argv[1], "throttle") == 0)
+    return bench_throttle();
+  if (strcmp(argv[1], "cruise") == 0)
+    return bench_cruise();
+  if (strcmp(argv[1], "rate") == 0)
+    return bench_rate();
+  fprintf(stderr, "unknown benchmark '%s'\n", argv[1]);
+  return 2;
+}
@@ -0,0 +1,94 @@
+/* Closed loop of vehicle model and cruise control, see closed_loop.h */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "closed_loop.h"
+
+void cl_init(closed_loop *cl, INT16U period_ms, int delay)
+{
+  memset(cl, 0, sizeof(*cl));
+  vm_init(&cl->vehicle, period_ms);
+  cruise_ctl_init(&cl->control, period_ms);
+  cl->delay = delay < 0 ? 0 : (delay > CL_MAX_DELAY ? CL_MAX_DELAY : delay);
+}
+
+void cl_step(closed_loop *cl, const cl_inputs *in)
+{
+  int i;
+
+  cl->throttle[cl->delay] = cruise_ctl_step(&cl->control, &in->driver, cl->vehicle.velocity,
+                                            vm_position(&cl->vehicle));
+  vm_step(&cl->vehicle, cl->throttle[0], in->driver.engine, in->brake);
+  cl->in = *in;
+  for (i = 0; i < cl->delay; i++)
+    cl->throttle[i] = cl->throttle[i + 1];
+  cl->time += cl->vehicle.period;
+}
+
+void cl_set_period(closed_loop *cl, INT16U period_ms)
+{
+  vm_set_period(&cl->vehicle, period_ms);
+  cruise_ctl_set_period(&cl->control, period_ms);
+}
+
+void cl_metrics_init(cl_metrics *m)
+{
+  memset(m, 0, sizeof(*m));
+}
+
+/* to be called after every cl_step() */
+void cl_metrics_add(cl_metrics *m, const closed_loop *cl)
+{
+  double t = cl->time / 1000.0;
+  double v = (double)cl->vehicle.velocity / VM_ONE;
+  double e;
+
+  m->effort += abs((int)cl->throttle[0] - (int)m->prev_throttle);
+  m->prev_throttle = cl->throttle[0];
+
+  if (!cl->control.cruising) {
+    m->interrupted = 0;
+    return;
+  }
+  if (cl->in.brake == on || cl->in.driver.engine == off) {
+    m->interrupted = 1;
+    m->in_band = -1;
+  }
+  if (m->interrupted)
+    return;
+  if (!m->engaged) {
+    m->engaged = 1;
+    m->engage_time = t;
+    m->target = (double)cl->control.target / VM_ONE;
+    m->in_band = -1;
+    m->settling_time = -1;
+  }
+
+  // error against the current target, cruise mode may be re-engaged later
+  e = v - (double)cl->control.target / VM_ONE;
+  if (e > m->overshoot)
+    m->overshoot = e;
+  if (fabs(e) > m->max_deviation)
+    m->max_deviation = fabs(e);
+  if (fabs(e) > CL_BAND) {
+    m->in_band = -1;
+  } else {
+    if (m->in_band < 0)
+      m->in_band = t;
+    if (m->settling_time < 0 && t - m->in_band >= CL_HOLD)
+      m->settling_time = m->in_band - m->engage_time;
+  }
+  m->sq_error += e * e;
+  m->samples++;
+}
+
+/* time from engagement until the velocity settled, < 0 if it never did [s] */
+double cl_settling_time(const cl_metrics *m)
+{
+  return m->engaged ? m->settling_time : -1;
+}
+
+double cl_rms_error(const cl_metrics *m)
+{
+  return m->samples ? sqrt(m->sq_error / m->samples) : 0;
+}
@@ -0,0 +1,70 @@
+/* Closed loop of vehicle model and cruise control without the RTOS
+ *
+ * Description:
+ *
+ *   Runs vm_step() and cruise_ctl_step() like VehicleTask and ControlTask
+ *   do on the board, one period per cl_step(). The throttle computed from a
+ *   velocity sample reaches the vehicle 'delay' periods later (0 matches the
+ *   board, where ControlTask runs before VehicleTask within a period, see
+ *   CRUISE_PIPELINE; 1 is a hand-over to the next period).
+ *
+ *   cl_set_period() changes the period of both between two steps, like the
+ *   adaptive rate of the board (ADAPTIVE_RATE in cruise_skeleton.c).
+ *
+ *   The cl_metrics functions evaluate a run: overshoot and settling time
+ *   after cruise mode is engaged, tracking error while cruising and throttle
+ *   effort. The track has hills, so the velocity is considered settled once
+ *   it stays within CL_BAND of the target for CL_HOLD seconds; later
+ *   deviations show up in max_deviation and the rms error. The controller
+ *   does not see the brake, so braking or stopping the engine ends an
+ *   engagement for the metrics until cruise mode is engaged again.
+ */
+#ifndef CLOSED_LOOP_H
+#define CLOSED_LOOP_H
+
+#include "cruise_control.h"
+#include "vehicle_model.h"
+
+#define CL_MAX_DELAY  8
+#define CL_BAND       0.5 /* settling band around the target [m/s] */
+#define CL_HOLD       3.0 /* time the velocity has to stay in the band [s] */
+
+typedef struct {
+  cruise_inputs driver;
+  enum active   brake;
+} cl_inputs;
+
+typedef struct {
+  vehicle_state vehicle;
+  cruise_ctl    control;
+  INT8U         throttle[CL_MAX_DELAY + 1]; /* [0] is applied to the vehicle */
+  int           delay;
+  INT32U        time;                       /* [ms] */
+  cl_inputs     in;                         /* of the last step */
+} closed_loop;
+
+typedef struct {
+  int    engaged;        /* cruise mode was engaged at least once */
+  double engage_time;    /* [s] */
+  double target;         /* target of the first engagement [m/s] */
+  double overshoot;      /* largest velocity above the target [m/s] */
+  double max_deviation;  /* largest |error| while cruising [m/s] */
+  int    interrupted;    /* braked or engine off since the engagement */
+  double in_band;        /* time |error| entered CL_BAND, < 0 when outside [s] */
+  double settling_time;  /* < 0 until settled [s] */
+  double sq_error;
+  double effort;         /* sum of |throttle changes| */
+  long   samples;
+  INT8U  prev_throttle;
+} cl_metrics;
+
+void   cl_init(closed_loop *cl, INT16U period_ms, int delay);
+void   cl_step(closed_loop *cl, const cl_inputs *in);
+void   cl_set_period(closed_loop *cl, INT16U period_ms);
+
+void   cl_metrics_init(cl_metrics *m);
+void   cl_metrics_add(cl_metrics *m, const closed_loop *cl);
+double cl_settling_time(const cl_metrics *m);
+double cl_rms_error(const cl_metrics *m);
+
+#endif /* CLOSED_LOOP_H */
@@ -0,0 +1,478 @@
+/* Batch simulator for the cruise control
+ *
+ * Description:
+ *
+ *   Runs the vehicle model and the control law of ControlTask (through
+ *   closed_loop.c) for many scripted scenarios, as fast as the host allows
+ *   and on all of its cores, without the RTOS.
+ *
+ *   usage: cruise_sim [options] [scenario file]
+ *
+ *     -n N      additionally generate N random scenarios
+ *     -s SEED   seed of the random scenarios (default 1)
+ *     -t MS     duration of the random scenarios (default 600000)
+ *     -p MS     control/vehicle period of the random scenarios (default 300)
+ *     -j N      number of worker threads (default: all cores)
+ *     -o FILE   write the trajectories to FILE (columnar format, see below)
+ *     -m FILE   write the summary metrics as CSV to FILE (default stdout)
+ *     -f MS     gradient feedforward with a lookahead of MS (cruise_control.h)
+ *     -k FILE   drive all scenarios on the track of FILE (format in
+ *               src/track.h) instead of the 2400 m loop of the lab
+ *
+ *   Scenario file:
+ *
+ *     scenario <name>
+ *       period <ms>          control/vehicle period, default 300
+ *       delay <periods>      throttle hand-over delay, default 0
+ *       duration <ms>
+ *       start <m>            initial position on the track, wraps at its length
+ *       at <ms> engine|gear|gas|brake|cruise on|off
+ *     end
+ *
+ *   Trajectory file: the header "CSIM" + INT32U version + INT32U number of
+ *   scenarios, then one block per scenario in completion order:
+ *
+ *     INT32U index, INT32U samples n, INT32U period [ms]
+ *     INT32S position [mm] x n
+ *     INT32S velocity [Q15.16 m/s] x n
+ *     INT8U  throttle x n
+ *     INT8U  flags x n    (bit 0 engine, 1 top gear, 2 gas, 3 brake,
+ *                          4 cruise switch, 5 cruising)
+ *
+ *   All values are little endian.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "closed_loop.h"
+
+#define SIM_MAX_EVENTS 256
+#define SIM_NAME_LEN   32
+#define SIM_VERSION    1
+
+enum sim_signal { SIG_ENGINE, SIG_GEAR, SIG_GAS, SIG_BRAKE, SIG_CRUISE };
+
+static const char *signal_names[] = {"engine", "gear", "gas", "brake", "cruise"};
+
+/* shared by all workers, read only once the scenarios run */
+static const track *road = &track_loop;
+static track road_file;
+static track_segment road_segments[TRACK_MAX_SEGMENTS];
+static int lookahead = -1; /* [ms], < 0: no feedforward */
+
+typedef struct {
+  INT32U          time;    /* [ms] */
+  enum sim_signal signal;
+  enum active     value;
+} sim_event;
+
+typedef struct {
+  char      name[SIM_NAME_LEN];
+  INT16U    period;
+  int       delay;
+  INT32U    duration;
+  INT32U    start;
+  int       n_events;
+  sim_event events[SIM_MAX_EVENTS];
+} scenario;
+
+typedef struct {
+  double    distance;  /* [m] */
+  cl_metrics metrics;
+} sim_result;
+
+typedef struct {
+  scenario   *scenarios;
+  sim_result *results;
+  int         count;
+  int         next;      /* next scenario to run */
+  FILE       *traj;
+  pthread_mutex_t lock;
+} sim_batch;
+
+/*
+ * Scenario file
+ */
+
+static int parse_signal(const char *s, enum sim_signal *sig)
+{
+  int i;
+
+  for (i = 0; i < 5; i++) {
+    if (strcmp(s, signal_names[i]) == 0) {
+      *sig = (enum sim_signal)i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static void scenario_defaults(scenario *sc)
+{
+  memset(sc, 0, sizeof(*sc));
+  sc->period = 300;
+  sc->delay = 0;
+  sc->duration = 60000;
+}
+
+static int load_scenarios(const char *path, scenario **list, int *count)
+{
+  FILE *f = fopen(path, "r");
+  char line[256], word[32], arg1[32], arg2[32], arg3[32];
+  scenario *sc = NULL;
+  int lineno = 0, n;
+  sim_event *ev;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    if (strchr(line, '#'))
+      *strchr(line, '#') = '\0';
+    n = sscanf(line, "%31s %31s %31s %31s", word, arg1, arg2, arg3);
+    if (n <= 0)
+      continue;
+
+    if (strcmp(word, "scenario") == 0 && n == 2 && sc == NULL) {
+      *list = realloc(*list, (*count + 1) * sizeof(scenario));
+      sc = &(*list)[(*count)++];
+      scenario_defaults(sc);
+      snprintf(sc->name, SIM_NAME_LEN, "%s", arg1);
+    } else if (sc == NULL) {
+      break;
+    } else if (strcmp(word, "end") == 0 && n == 1) {
+      sc = NULL;
+    } else if (strcmp(word, "period") == 0 && n == 2 && atoi(arg1) > 0) {
+      sc->period = (INT16U)atoi(arg1);
+    } else if (strcmp(word, "delay") == 0 && n == 2) {
+      sc->delay = atoi(arg1);
+    } else if (strcmp(word, "duration") == 0 && n == 2) {
+      sc->duration = (INT32U)atol(arg1);
+    } else if (strcmp(word, "start") == 0 && n == 2) {
+      sc->start = (INT32U)atol(arg1) % road->length;
+    } else if (strcmp(word, "at") == 0 && n == 4 && sc->n_events < SIM_MAX_EVENTS) {
+      ev = &sc->events[sc->n_events];
+      if (parse_signal(arg2, &ev->signal) < 0)
+        break;
+      if (strcmp(arg3, "on") != 0 && strcmp(arg3, "off") != 0)
+        break;
+      ev->time = (INT32U)atol(arg1);
+      ev->value = strcmp(arg3, "on") == 0 ? on : off;
+      sc->n_events++;
+    } else {
+      break;
+    }
+  }
+  if (!feof(f) || sc != NULL) {
+    fprintf(stderr, "%s:%d: syntax error\n", path, lineno);
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+  return 0;
+}
+
+/*
+ * Random scenarios: engine on and top gear from the start, then every 5 to
+ * 30 s the driver presses or releases the gas pedal, brakes for 1 to 3 s,
+ * toggles the cruise control or changes gear.
+ */
+static INT32U lcg(INT32U *state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 8;
+}
+
+static void add_event(scenario *sc, INT32U t, enum sim_signal sig, enum active value)
+{
+  if (sc->n_events < SIM_MAX_EVENTS) {
+    sc->events[sc->n_events].time = t;
+    sc->events[sc->n_events].signal = sig;
+    sc->events[sc->n_events].value = value;
+    sc->n_events++;
+  }
+}
+
+static void random_scenario(scenario *sc, int index, INT32U seed, INT32U duration, INT16U period)
+{
+  INT32U state = seed * 7919u + (INT32U)index;
+  enum active gas = on, cruise = off, gear = on;
+  INT32U t = 0;
+
+  scenario_defaults(sc);
+  snprintf(sc->name, SIM_NAME_LEN, "random%d", index);
+  sc->period = period;
+  sc->duration = duration;
+  sc->start = lcg(&state) % road->length;
+  add_event(sc, 0, SIG_ENGINE, on);
+  add_event(sc, 0, SIG_GEAR, on);
+  add_event(sc, 0, SIG_GAS, on);
+
+  while (sc->n_events < SIM_MAX_EVENTS - 2) {
+    t += 5000 + lcg(&state) % 25000;
+    if (t >= duration)
+      break;
+    switch (lcg(&state) % 4) {
+      case 0:
+        gas = (gas == on) ? off : on;
+        add_event(sc, t, SIG_GAS, gas);
+        break;
+      case 1:
+        add_event(sc, t, SIG_BRAKE, on);
+        add_event(sc, t + 1000 + lcg(&state) % 2000, SIG_BRAKE, off);
+        break;
+      case 2:
+        cruise = (cruise == on) ? off : on;
+        add_event(sc, t, SIG_CRUISE, cruise);
+        break;
+      default:
+        gear = (gear == on) ? off : on;
+        add_event(sc, t, SIG_GEAR, gear);
+        break;
+    }
+  }
+}
+
+/*
+ * Simulation
+ */
+
+static void apply_event(cl_inputs *in, const sim_event *ev)
+{
+  switch (ev->signal) {
+    case SIG_ENGINE: in->driver.engine = ev->value; break;
+    case SIG_GEAR:   in->driver.top_gear = ev->value; break;
+    case SIG_GAS:    in->driver.gas_pedal = ev->value; break;
+    case SIG_BRAKE:  in->brake = ev->value; break;
+    case SIG_CRUISE: in->driver.cruise_control = ev->value; break;
+  }
+}
+
+static INT8U flags_of(const cl_inputs *in, const closed_loop *cl)
+{
+  return (in->driver.engine == on)
+    | (in->driver.top_gear == on) << 1
+    | (in->driver.gas_pedal == on) << 2
+    | (in->brake == on) << 3
+    | (in->driver.cruise_control == on) << 4
+    | (cl->control.cruising != 0) << 5;
+}
+
+/* events may be listed in any order */
+static int event_cmp(const void *a, const void *b)
+{
+  const sim_event *x = a, *y = b;
+
+  return (x->time > y->time) - (x->time < y->time);
+}
+
+static void write_block(sim_batch *b, INT32U index, INT32U n, INT32U period,
+    const INT32S *pos, const INT32S *vel, const INT8U *thr, const INT8U *flags)
+{
+  pthread_mutex_lock(&b->lock);
+  fwrite(&index, 4, 1, b->traj);
+  fwrite(&n, 4, 1, b->traj);
+  fwrite(&period, 4, 1, b->traj);
+  fwrite(pos, 4, n, b->traj);
+  fwrite(vel, 4, n, b->traj);
+  fwrite(thr, 1, n, b->traj);
+  fwrite(flags, 1, n, b->traj);
+  pthread_mutex_unlock(&b->lock);
+}
+
+static void run_scenario(sim_batch *b, int index)
+{
+  scenario *sc = &b->scenarios[index];
+  sim_result *r = &b->results[index];
+  INT32U n = sc->duration / sc->period, k;
+  INT32S *pos = NULL, *vel = NULL;
+  INT8U *thr = NULL, *flags = NULL;
+  closed_loop cl;
+  cl_inputs in;
+  int e = 0;
+
+  qsort(sc->events, sc->n_events, sizeof(sim_event), event_cmp);
+  if (b->traj) {
+    pos = malloc(n * sizeof(INT32S));
+    vel = malloc(n * sizeof(INT32S));
+    thr = malloc(n);
+    flags = malloc(n);
+  }
+
+  cl_init(&cl, sc->period, sc->delay);
+  vm_set_track(&cl.vehicle, road);
+  if (lookahead >= 0)
+    cruise_ctl_set_feedforward(&cl.control, road, (INT16U)lookahead);
+  cl.vehicle.position = VM_POS_FROM_INT(sc->start);
+  cl_metrics_init(&r->metrics);
+  r->distance = 0;
+  in.driver.engine = in.driver.top_gear = in.driver.gas_pedal = off;
+  in.driver.cruise_control = off;
+  in.brake = off;
+
+  for (k = 0; k < n; k++) {
+    while (e < sc->n_events && sc->events[e].time <= cl.time)
+      apply_event(&in, &sc->events[e++]);
+    cl_step(&cl, &in);
+    cl_metrics_add(&r->metrics, &cl);
+    r->distance += (double)cl.vehicle.velocity / VM_ONE * sc->period / 1000.0;
+    if (b->traj) {
+      pos[k] = (INT32S)((cl.vehicle.position * 1000) >> VM_POS_FRAC_BITS);
+      vel[k] = cl.vehicle.velocity;
+      thr[k] = cl.throttle[0];
+      flags[k] = flags_of(&in, &cl);
+    }
+  }
+
+  if (b->traj) {
+    write_block(b, (INT32U)index, n, sc->period, pos, vel, thr, flags);
+    free(pos);
+    free(vel);
+    free(thr);
+    free(flags);
+  }
+}
+
+static void *worker(void *arg)
+{
+  sim_batch *b = arg;
+  int index;
+
+  while (1) {
+    pthread_mutex_lock(&b->lock);
+    index = b->next++;
+    pthread_mutex_unlock(&b->lock);
+    if (index >= b->count)
+      break;
+    run_scenario(b, index);
+  }
+  return NULL;
+}
+
+static void write_metrics(FILE *f, const sim_batch *b)
+{
+  int i;
+
+  fprintf(f, "scenario,name,duration_s,distance_m,engaged,target,overshoot,settling_s,max_dev,rms_err,effort\n");
+  for (i = 0; i < b->count; i++) {
+    const scenario *sc = &b->scenarios[i];
+    const cl_metrics *m = &b->results[i].metrics;
+
+    fprintf(f, "%d,%s,%.1f,%.1f,%d,%.2f,%.3f,%.1f,%.3f,%.4f,%.0f\n", i, sc->name,
+        sc->duration / 1000.0, b->results[i].distance, m->engaged, m->target,
+        m->overshoot, cl_settling_time(m), m->max_deviation, cl_rms_error(m), m->effort);
+  }
+}
+
+static double now_s(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  sim_batch b;
+  scenario *list = NULL;
+  int count = 0, random_count = 0, threads, i, opt, n;
+  INT32U seed = 1, duration = 600000;
+  INT16U period = 300;
+  const char *traj_path = NULL, *metrics_path = NULL;
+  pthread_t *tid;
+  double t0, wall, simulated = 0;
+  FILE *mf = stdout;
+
+  threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc, argv, "n:s:t:p:j:o:m:f:k:")) != -1) {
+    switch (opt) {
+      case 'n': random_count = atoi(optarg); break;
+      case 's': seed = (INT32U)atol(optarg); break;
+      case 't': duration = (INT32U)atol(optarg); break;
+      case 'p': period = (INT16U)atoi(optarg); break;
+      case 'j': threads = atoi(optarg); break;
+      case 'o': traj_path = optarg; break;
+      case 'm': metrics_path = optarg; break;
+      case 'f': lookahead = atoi(optarg); break;
+      case 'k':
+        n = track_load(optarg, road_segments, TRACK_MAX_SEGMENTS);
+        if (n < 0 || track_init(&road_file, road_segments, (INT16U)n) < 0) {
+          fprintf(stderr, "%s: invalid track\n", optarg);
+          return 1;
+        }
+        road = &road_file;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n N] [-s SEED] [-t MS] [-p MS] [-j N] [-o FILE] [-m FILE] [-f MS] [-k FILE] "
+            "[scenarios]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind < argc && load_scenarios(argv[optind], &list, &count) < 0)
+    return 1;
+  if (period == 0 || threads < 1) {
+    fprintf(stderr, "invalid period or thread count\n");
+    return 2;
+  }
+  if (random_count > 0) {
+    list = realloc(list, (count + random_count) * sizeof(scenario));
+    for (i = 0; i < random_count; i++)
+      random_scenario(&list[count + i], i, seed, duration, period);
+    count += random_count;
+  }
+  if (count == 0) {
+    fprintf(stderr, "no scenarios\n");
+    return 2;
+  }
+
+  memset(&b, 0, sizeof(b));
+  b.scenarios = list;
+  b.count = count;
+  b.results = calloc(count, sizeof(sim_result));
+  pthread_mutex_init(&b.lock, NULL);
+  if (traj_path) {
+    INT32U header[2] = {SIM_VERSION, (INT32U)count};
+
+    b.traj = fopen(traj_path, "wb");
+    if (b.traj == NULL) {
+      perror(traj_path);
+      return 1;
+    }
+    fwrite("CSIM", 1, 4, b.traj);
+    fwrite(header, 4, 2, b.traj);
+  }
+
+  t0 = now_s();
+  tid = malloc(threads * sizeof(pthread_t));
+  for (i = 0; i < threads; i++)
+    pthread_create(&tid[i], NULL, worker, &b);
+  for (i = 0; i < threads; i++)
+    pthread_join(tid[i], NULL);
+  wall = now_s() - t0;
+
+  if (b.traj)
+    fclose(b.traj);
+  if (metrics_path && (mf = fopen(metrics_path, "w")) == NULL) {
+    perror(metrics_path);
+    return 1;
+  }
+  write_metrics(mf, &b);
+  if (mf != stdout)
+    fclose(mf);
+
+  for (i = 0; i < count; i++)
+    simulated += list[i].duration / 1000.0;
+  fprintf(stderr, "%d scenarios, %.1f h simulated in %.2f s on %d threads (%.0fx real time)\n",
+      count, simulated / 3600, wall, threads, wall > 0 ? simulated / wall : 0);
+
+  free(tid);
+  free(b.results);
+  free(list);
+  return 0;
+}
@@ -0,0 +1,160 @@
+/* Overload headroom search on a simulated scheduler
+ *
+ * Description:
+ *
+ *   Runs the headroom search of src/headroom.c (the one HEADROOM_TEST runs
+ *   on the board) against a simulation of the task set of src/cruise_tasks.h
+ *   under fixed-priority preemptive scheduling: all tasks are released at
+ *   their pipeline offset (CRUISE_PIPELINE) and then periodically, a task
+ *   released while its previous release still runs has missed its deadline.
+ *
+ *   Every release of a task executes its budget from the task table times
+ *   the scale factor (-c), reduced by a uniformly random fraction of up to
+ *   -j percent, so with -j the trials see different execution times.
+ *   ExtraloadTask executes its budget plus the probed extra load.
+ *
+ *   usage: headroom_sim [-c scale] [-j percent] [-p hyperperiods]
+ *                       [-r per mille] [-s seed] [-t trials]
+ *
+ *   A load passes if no deadline is missed in -p hyperperiods. The result
+ *   is the extra load of ExtraloadTask in per mille of its period, for
+ *   every trial, which should agree with the headroom printed by rta when
+ *   -j is 0.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "cruise_tasks.h"
+#include "headroom.h"
+
+typedef struct {
+  const char *name;
+  int    prio;
+  long   period;    /* all times in us */
+  long   deadline;
+  long   budget;
+  long   next;      /* next release */
+  long   release;   /* of the running release */
+  long   left;      /* execution time left, 0: idle */
+} sim_task;
+
+#define TASK_ENTRY(name, period, deadline, budget, crit, stack) \
+  { #name, TASK_PRIO(name), (period) * 1000L, (deadline) * 1000L, budget, 0, 0, 0 },
+static sim_task tasks[] = { CRUISE_TASKS(TASK_ENTRY) };
+#undef TASK_ENTRY
+
+static const int offset[TASK_COUNT] = TASK_OFFSETS; /* [ms] */
+
+static double scale = 1.0;
+static int jitter;         /* percent */
+static INT32U seed = 1;
+
+static INT32U rand32(void)
+{
+  seed = seed * 1664525UL + 1013904223UL;
+  return seed;
+}
+
+static long exec_time(const sim_task *t, INT16U extra)
+{
+  long c = (long)(t->budget * scale);
+
+  if (jitter)
+    c -= (long)((double)c * jitter / 100 * (rand32() >> 8) / (1 << 24));
+  if (t == &tasks[ExtraloadTask_id])
+    c += (long)extra * t->period / 1000;
+  return c;
+}
+
+/* Returns 1 if a deadline was missed within 'hyperperiods' */
+static int simulate(INT16U extra, int hyperperiods)
+{
+  const int n = TASK_COUNT;
+  long now = 0, end = (long)hyperperiods * HYPERPERIOD * 1000L, next;
+  sim_task *run;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    tasks[i].next = offset[i] * 1000L;
+    tasks[i].left = 0;
+  }
+  while (now < end) {
+    /* releases due now */
+    for (i = 0; i < n; i++) {
+      sim_task *t = &tasks[i];
+
+      if (t->next > now)
+        continue;
+      if (t->left > 0)
+        return 1;
+      t->release = now;
+      t->left = exec_time(t, extra);
+      t->next += t->period;
+    }
+
+    /* highest priority ready task runs until it finishes or the next release */
+    next = end;
+    run = NULL;
+    for (i = 0; i < n; i++) {
+      if (tasks[i].next < next)
+        next = tasks[i].next;
+      if (tasks[i].left > 0 && (run == NULL || tasks[i].prio < run->prio))
+        run = &tasks[i];
+    }
+    if (run != NULL && now + run->left <= next) {
+      now += run->left;
+      run->left = 0;
+      if (now - run->release > run->deadline)
+        return 1;
+    } else {
+      if (run != NULL)
+        run->left -= next - now;
+      now = next;
+    }
+  }
+  for (i = 0; i < n; i++)
+    if (tasks[i].left > 0 && now - tasks[i].release > tasks[i].deadline)
+      return 1;
+  return 0;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-c scale] [-j percent] [-p hyperperiods] [-r per mille] [-s seed] "
+      "[-t trials]\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  headroom h;
+  int hyperperiods = 10, resolution = 1, trials = 5, probes = 0, opt;
+
+  while ((opt = getopt(argc, argv, "c:j:p:r:s:t:")) != -1) {
+    switch (opt) {
+    case 'c': scale = atof(optarg); break;
+    case 'j': jitter = atoi(optarg); break;
+    case 'p': hyperperiods = atoi(optarg); break;
+    case 'r': resolution = atoi(optarg); break;
+    case 's': seed = (INT32U)strtoul(optarg, NULL, 0); break;
+    case 't': trials = atoi(optarg); break;
+    default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || scale < 0 || jitter < 0 || jitter > 100 || hyperperiods < 1
+      || trials < 1 || trials > HEADROOM_MAX_TRIALS)
+    usage(argv[0]);
+
+  if (simulate(0, hyperperiods)) {
+    printf("deadline missed without extra load\n");
+    return 1;
+  }
+  headroom_init(&h, (INT16U)resolution, (INT8U)trials);
+  while (!headroom_done(&h)) {
+    headroom_report(&h, simulate(headroom_probe(&h), hyperperiods));
+    probes++;
+  }
+  printf("%d probes of %d hyperperiods (%d ms)\n", probes, hyperperiods, HYPERPERIOD);
+  headroom_print(&h);
+  return 0;
+}
@@ -0,0 +1,156 @@
+/* Platoon of vehicles, see platoon.h */
+#include <stdlib.h>
+#include <string.h>
+#include "platoon.h"
+
+/* (a * b) >> shift with a 64 bit intermediate, rounded to nearest, like vehicle_model.c */
+static inline INT64S mul_shift(INT64S a, INT64S b, int shift)
+{
+  return (a * b + ((INT64S)1 << (shift - 1))) >> shift;
+}
+
+static void *array(int n, size_t size)
+{
+  void *a = aligned_alloc(64, ((n * size + 63) / 64) * 64);
+
+  if (a != NULL)
+    memset(a, 0, n * size);
+  return a;
+}
+
+int pl_init(platoon *p, int n, INT16U period_ms, const track *t, INT32U spacing, int gap_keeping)
+{
+  vehicle_state vs;
+  int i;
+
+  memset(p, 0, sizeof(*p));
+  vm_init(&vs, period_ms);
+  p->n = n;
+  p->gap_keeping = gap_keeping;
+  p->period = period_ms;
+  p->dt = vs.dt;
+  p->track = t;
+  p->position = array(n, sizeof(INT64S));
+  p->velocity = array(n, sizeof(INT32S));
+  p->acceleration = array(n, sizeof(INT32S));
+  p->drive = array(n, sizeof(INT32S));
+  p->brake = array(n, sizeof(INT32S));
+  p->throttle = array(n, sizeof(INT8U));
+  p->control = array(n, sizeof(cruise_ctl));
+  if (!p->position || !p->velocity || !p->acceleration || !p->drive || !p->brake
+      || !p->throttle || !p->control) {
+    pl_free(p);
+    return -1;
+  }
+  // the leader starts at n - 1 gaps from the start of the track
+  for (i = 0; i < n; i++) {
+    p->position[i] = VM_POS_FROM_INT((INT64S)(n - 1 - i) * spacing);
+    cruise_ctl_init(&p->control[i], period_ms);
+  }
+  return 0;
+}
+
+void pl_free(platoon *p)
+{
+  free(p->position);
+  free(p->velocity);
+  free(p->acceleration);
+  free(p->drive);
+  free(p->brake);
+  free(p->throttle);
+  free(p->control);
+  memset(p, 0, sizeof(*p));
+}
+
+void pl_set_feedforward(platoon *p, int lookahead_ms)
+{
+  int i;
+
+  for (i = 0; i < p->n; i++)
+    cruise_ctl_set_feedforward(&p->control[i], lookahead_ms < 0 ? NULL : p->track,
+                               (INT16U)(lookahead_ms < 0 ? 0 : lookahead_ms));
+}
+
+double pl_gap(const platoon *p, int i)
+{
+  return (double)(p->position[i - 1] - p->position[i]) / VM_POS_FROM_INT(1) - PL_LENGTH;
+}
+
+/*
+ * Gap keeping of follower i: the target while cruising is the velocity
+ * ahead, plus the gap error closed in 1 / PL_GAP_GAIN s
+ */
+static void keep_gap(platoon *p, int i)
+{
+  double gap = pl_gap(p, i);
+  double desired = PL_GAP_MIN + PL_TIME_GAP * p->velocity[i] / VM_ONE;
+  double target = (double)p->velocity[i - 1] / VM_ONE + PL_GAP_GAIN * (gap - desired);
+
+  cruise_ctl_set_target(&p->control[i], target < 0 ? 0 : (INT32S)(target * VM_ONE));
+  p->brake[i] = p->control[i].cruising && gap < PL_BRAKE_GAP * desired;
+}
+
+/*
+ * The controllers, one instance per vehicle, and the inputs of the vehicle
+ * update: throttle and gravity of every vehicle in 'drive'
+ */
+void pl_control(platoon *p, const cruise_inputs *driver)
+{
+  const INT32U length = p->track->length;
+  INT64S m;
+  INT32U position;
+  INT8U throttle;
+  int i;
+
+  for (i = 0; i < p->n; i++) {
+    /* positions are not wrapped, a vehicle rolling back from 0 is negative */
+    m = (p->position[i] >> VM_POS_FRAC_BITS) % length;
+    position = (INT32U)(m < 0 ? m + length : m);
+    if (p->gap_keeping && i > 0)
+      keep_gap(p, i);
+    throttle = cruise_ctl_step(&p->control[i], driver, p->velocity[i], position);
+    p->throttle[i] = throttle;
+    if (throttle > VM_MAX_THROTTLE)
+      throttle = VM_MAX_THROTTLE;
+    p->drive[i] = track_slope(p->track, position)
+                + (driver->engine == on ? VM_FROM_INT(throttle) : 0);
+  }
+}
+
+/*
+ * vm_step() for all vehicles at once: no branches and no calls, so the loop
+ * vectorizes. The arrays are only accessed through the restrict pointers.
+ */
+static void step_vehicles(platoon *p)
+{
+  INT64S *restrict position = p->position;
+  INT32S *restrict velocity = p->velocity;
+  INT32S *restrict acceleration = p->acceleration;
+  const INT32S *restrict drive = p->drive;
+  const INT32S *restrict brake = p->brake;
+  const INT64S dt = p->dt;
+  const int n = p->n;
+  INT32S v, a;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    v = velocity[i];
+    a = brake[i] ? -VM_BRAKE_FACTOR * v : -VM_WIND_FACTOR * v + drive[i];
+    acceleration[i] = a;
+    position[i] += mul_shift(v, dt, VM_FRAC_BITS + VM_DT_FRAC_BITS - VM_POS_FRAC_BITS);
+    velocity[i] += (INT32S)mul_shift(a, dt, VM_DT_FRAC_BITS);
+  }
+  p->time += p->period;
+}
+
+void pl_vehicles(platoon *p, enum active leader_brake)
+{
+  p->brake[0] = leader_brake == on;
+  step_vehicles(p);
+}
+
+void pl_step(platoon *p, const cruise_inputs *driver, enum active leader_brake)
+{
+  pl_control(p, driver);
+  pl_vehicles(p, leader_brake);
+}
@@ -0,0 +1,64 @@
+/* Platoon of vehicles without the RTOS
+ *
+ * Description:
+ *
+ *   Simulates n vehicles on one track per pl_step(), each with the vehicle
+ *   model of vehicle_model.c and its own instance of the control law of
+ *   ControlTask (delay 0, like closed_loop.c). Vehicle 0 leads, the others
+ *   follow in order.
+ *
+ *   The state is kept as a structure of arrays, so the update of all
+ *   vehicles is one loop over flat arrays without branches that the host
+ *   compiler vectorizes; it computes the same as vm_step(). Positions are
+ *   not wrapped at the end of the track, so a gap is a difference of two
+ *   positions.
+ *
+ *   All vehicles get the same driver inputs, only the leader brakes. With
+ *   gap keeping, a follower that is cruising moves its target to the
+ *   velocity of the vehicle ahead, corrected by PL_GAP_GAIN times the
+ *   deviation from the desired gap PL_GAP_MIN + PL_TIME_GAP * velocity,
+ *   and brakes while the gap is below PL_BRAKE_GAP of the desired gap.
+ */
+#ifndef PLATOON_H
+#define PLATOON_H
+
+#include "cruise_control.h"
+#include "vehicle_model.h"
+
+#define PL_LENGTH    5    /* of a vehicle [m] */
+#define PL_GAP_MIN   5.0  /* [m] */
+#define PL_TIME_GAP  0.8  /* [s] */
+#define PL_GAP_GAIN  0.3  /* [1/s] */
+#define PL_BRAKE_GAP 0.5  /* of the desired gap */
+
+typedef struct {
+  int          n;
+  int          gap_keeping;
+  INT16U       period;    /* [ms] */
+  INT32S       dt;        /* Q7.24 [s] */
+  const track *track;
+  INT32U       time;      /* [ms] */
+
+  /* one element per vehicle */
+  INT64S      *position;      /* Q31.32 [m], not wrapped */
+  INT32S      *velocity;      /* Q15.16 [m/s] */
+  INT32S      *acceleration;  /* Q15.16 [m/s^2] */
+  INT32S      *drive;         /* throttle + gravity of the step Q15.16 [m/s^2] */
+  INT32S      *brake;         /* 1: braking */
+  INT8U       *throttle;
+  cruise_ctl  *control;
+} platoon;
+
+/* Returns -1 if out of memory; the vehicles start 'spacing' m apart, at rest */
+int  pl_init(platoon *p, int n, INT16U period_ms, const track *t, INT32U spacing, int gap_keeping);
+void pl_free(platoon *p);
+/* 'lookahead' < 0: no feedforward, see cruise_ctl_set_feedforward() */
+void pl_set_feedforward(platoon *p, int lookahead_ms);
+/* Runs the controllers, then the vehicles, one period */
+void pl_control(platoon *p, const cruise_inputs *driver);
+void pl_vehicles(platoon *p, enum active leader_brake);
+void pl_step(platoon *p, const cruise_inputs *driver, enum active leader_brake);
+/* Gap from the back of vehicle i - 1 to vehicle i [m] */
+double pl_gap(const platoon *p, int i);
+
+#endif /* PLATOON_H */
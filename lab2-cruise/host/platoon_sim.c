@@ -0,0 +1,210 @@
+/* Platoon simulator
+ *
+ * Description:
+ *
+ *   Runs a platoon of vehicles (platoon.c) through a drive: the vehicles
+ *   start at rest, 'spacing' m apart, accelerate with the gas pedal for 8 s,
+ *   engage cruise mode at 9 s and cruise over the hills of the track; the
+ *   leader brakes from 60 to 62 s.
+ *
+ *   usage: platoon_sim [-g] [-f lookahead ms] [-k track file] [-n vehicles]
+ *                      [-p period ms] [-s spacing m] [-t duration ms]
+ *
+ *     -g   followers keep the gap to the vehicle ahead (platoon.h)
+ *
+ *   It first checks that a platoon of one computes the same as the closed
+ *   loop of closed_loop.c, then prints the gaps of the drive, and finally
+ *   the time per step against the number of vehicles, for the controllers,
+ *   for the vehicle update over the arrays and, for comparison, for
+ *   vm_step() called for every vehicle.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "closed_loop.h"
+#include "platoon.h"
+
+static double now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Inputs of the drive at 'time' [ms] */
+static void drive_inputs(INT32U time, cruise_inputs *in, enum active *brake)
+{
+  in->engine = on;
+  in->top_gear = on;
+  in->gas_pedal = time < 8000 ? on : off;
+  in->cruise_control = time >= 9000 ? on : off;
+  *brake = time >= 60000 && time < 62000 ? on : off;
+}
+
+/* A platoon of one against closed_loop.c, returns the first differing step or -1 */
+static long check_single(INT16U period, int lookahead, INT32U duration)
+{
+  platoon p;
+  closed_loop cl;
+  cl_inputs in;
+  long k;
+
+  if (pl_init(&p, 1, period, &track_loop, 0, 0) < 0)
+    return 0;
+  pl_set_feedforward(&p, lookahead);
+  cl_init(&cl, period, 0);
+  if (lookahead >= 0)
+    cruise_ctl_set_feedforward(&cl.control, cl.vehicle.track, (INT16U)lookahead);
+  for (k = 0; cl.time < duration; k++) {
+    drive_inputs(cl.time, &in.driver, &in.brake);
+    cl_step(&cl, &in);
+    pl_step(&p, &in.driver, in.brake);
+    if (p.throttle[0] != cl.throttle[0] || p.velocity[0] != cl.vehicle.velocity
+        || p.acceleration[0] != cl.vehicle.acceleration
+        || p.position[0] % VM_POS_FROM_INT(track_loop.length) != cl.vehicle.position)
+      break;
+  }
+  pl_free(&p);
+  return cl.time < duration ? k : -1;
+}
+
+static void drive(platoon *p, INT32U duration)
+{
+  cruise_inputs in;
+  enum active brake;
+  double gap, min_gap = 1e9, max_err = 0, err;
+  int i, collisions = 0, min_at = 0;
+
+  while (p->time < duration) {
+    drive_inputs(p->time, &in, &brake);
+    pl_step(p, &in, brake);
+    for (i = 1; i < p->n; i++) {
+      gap = pl_gap(p, i);
+      if (gap < min_gap) {
+        min_gap = gap;
+        min_at = i;
+      }
+      if (gap < 0)
+        collisions++;
+      // the gap error once the gaps had time to settle after engaging
+      err = gap - PL_GAP_MIN - PL_TIME_GAP * p->velocity[i] / VM_ONE;
+      if (p->time >= 30000 && (err < 0 ? -err : err) > max_err)
+        max_err = err < 0 ? -err : err;
+    }
+  }
+  printf("drive: %d vehicles, %.0f s, gap keeping %s\n", p->n, duration / 1000.0,
+      p->gap_keeping ? "on" : "off");
+  if (p->n < 2)
+    return;
+  printf("  smallest gap %.1f m (vehicle %d), %d vehicle steps with overlapping vehicles\n",
+      min_gap, min_at, collisions);
+  printf("  largest gap error from 30 s on %.1f m\n", max_err);
+  printf("  vehicle  velocity  gap\n");
+  for (i = 0; i < p->n && i < 8; i++)
+    printf("  %7d  %5.2f m/s  %6.1f m\n", i, (double)p->velocity[i] / VM_ONE,
+        i ? pl_gap(p, i) : 0.0);
+}
+
+static void timing(INT16U period, int lookahead, int gap_keeping)
+{
+  static const int sizes[] = {1, 10, 100, 1000, 10000, 100000};
+  vehicle_state *scalar;
+  cruise_inputs in;
+  enum active brake;
+  platoon p;
+  double t0, t_ctl, t_soa, t_scalar;
+  long steps, k;
+  int s, i;
+
+  printf("time per vehicle and step [ns]\n");
+  printf("  vehicles   control  update (arrays)  update (vm_step)\n");
+  for (s = 0; s < 6; s++) {
+    if (pl_init(&p, sizes[s], period, &track_loop, 60, gap_keeping) < 0)
+      break;
+    pl_set_feedforward(&p, lookahead);
+    scalar = malloc(sizes[s] * sizeof(vehicle_state));
+    for (i = 0; i < sizes[s]; i++)
+      vm_init(&scalar[i], period);
+    steps = 20000000L / sizes[s];
+    if (steps > 20000)
+      steps = 20000;
+    t_ctl = t_soa = t_scalar = 0;
+    for (k = 0; k < steps; k++) {
+      drive_inputs(p.time, &in, &brake);
+      t0 = now_ns();
+      pl_control(&p, &in);
+      t_ctl += now_ns() - t0;
+      t0 = now_ns();
+      pl_vehicles(&p, brake);
+      t_soa += now_ns() - t0;
+      t0 = now_ns();
+      for (i = 0; i < sizes[s]; i++)
+        vm_step(&scalar[i], p.throttle[i], in.engine, i == 0 ? brake : off);
+      t_scalar += now_ns() - t0;
+    }
+    printf("  %8d  %8.1f  %15.2f  %16.2f\n", sizes[s], t_ctl / steps / sizes[s],
+        t_soa / steps / sizes[s], t_scalar / steps / sizes[s]);
+    free(scalar);
+    pl_free(&p);
+  }
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-g] [-f lookahead ms] [-k track file] [-n vehicles] [-p period ms] "
+      "[-s spacing m] [-t duration ms]\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  static track road_file;
+  static track_segment segments[TRACK_MAX_SEGMENTS];
+  const track *road = &track_loop;
+  platoon p;
+  INT32U duration = 120000, spacing = 30;
+  int n = 8, gap_keeping = 0, lookahead = -1, period = 300, opt, count;
+  long diff;
+
+  while ((opt = getopt(argc, argv, "gf:k:n:p:s:t:")) != -1) {
+    switch (opt) {
+    case 'g': gap_keeping = 1; break;
+    case 'f': lookahead = atoi(optarg); break;
+    case 'k':
+      count = track_load(optarg, segments, TRACK_MAX_SEGMENTS);
+      if (count < 0 || track_init(&road_file, segments, (INT16U)count) < 0) {
+        fprintf(stderr, "%s: invalid track\n", optarg);
+        return 1;
+      }
+      road = &road_file;
+      break;
+    case 'n': n = atoi(optarg); break;
+    case 'p': period = atoi(optarg); break;
+    case 's': spacing = (INT32U)atol(optarg); break;
+    case 't': duration = (INT32U)atol(optarg); break;
+    default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || n < 1 || period < 1 || period > 65535)
+    usage(argv[0]);
+
+  diff = check_single((INT16U)period, lookahead, duration);
+  if (diff >= 0) {
+    printf("check: FAILED, a platoon of one differs from closed_loop.c at step %ld\n", diff);
+    return 1;
+  }
+  printf("check: a platoon of one computes the same as closed_loop.c\n");
+
+  if (pl_init(&p, n, (INT16U)period, road, spacing, gap_keeping) < 0) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  pl_set_feedforward(&p, lookahead);
+  drive(&p, duration);
+  pl_free(&p);
+
+  timing((INT16U)period, lookahead, gap_keeping);
+  return 0;
+}
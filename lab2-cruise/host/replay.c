@@ -0,0 +1,118 @@
+/* Input replay on the host closed loop
+ *
+ * Description:
+ *
+ *   Runs a replay script (format in src/input_replay.h) through the closed
+ *   loop of closed_loop.c, with the key and switch decoding of ButtonIO and
+ *   SwitchIO and the release order of CRUISE_PIPELINE: in every period of
+ *   ControlTask the inputs are sampled first, then ControlTask and
+ *   VehicleTask run.
+ *
+ *   usage: replay [-n] [-t duration ms] script
+ *
+ *   The output is the CSV of tel_decode, one line per period of
+ *   VehicleTask, with the values quantized like the telemetry records, so
+ *   it can be compared line by line with the decoded telemetry of the board
+ *   running the same script with INPUT_REPLAY (the extra load of
+ *   ExtraloadTask is not simulated, it does not change the outputs). The
+ *   duration defaults to the script length plus 10 s. The controller uses
+ *   the gradient feedforward like ControlTask with FEEDFORWARD, -n turns it
+ *   off.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "closed_loop.h"
+#include "cruise_tasks.h"
+#include "input_replay.h"
+#include "telemetry.h"
+
+#define MAX_STATES 4096
+
+#define CRUISE_CONTROL_FLAG 0x2 /* keys, like ButtonIO */
+#define BRAKE_PEDAL_FLAG    0x4
+#define GAS_PEDAL_FLAG      0x8
+#define ENGINE_FLAG         0x1 /* switches, like SwitchIO */
+#define TOP_GEAR_FLAG       0x2
+
+static replay_event script[MAX_STATES];
+
+static INT16S q78(INT32S x)
+{
+  x >>= 8;
+  return (INT16S)(x > 32767 ? 32767 : x < -32768 ? -32768 : x);
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n] [-t duration ms] script\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  closed_loop cl;
+  cl_inputs in = {{off, off, off, off}, off};
+  tel_record r;
+  INT32U t, duration = 0;
+  INT32S target;
+  INT8U seq = 0;
+  int n, keys, opt, feedforward = 1;
+
+  while ((opt = getopt(argc, argv, "nt:")) != -1) {
+    switch (opt) {
+    case 'n': feedforward = 0; break;
+    case 't': duration = (INT32U)strtoul(optarg, NULL, 0); break;
+    default: usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1)
+    usage(argv[0]);
+  n = replay_load(argv[optind], script, MAX_STATES);
+  if (n < 0)
+    return 1;
+  replay_init(script, (INT16U)n);
+  if (duration == 0)
+    duration = replay_length() + 10000;
+
+  cl_init(&cl, CONTROL_PERIOD, 0);
+  if (feedforward)
+    cruise_ctl_set_feedforward(&cl.control, cl.vehicle.track, CRUISE_FF_LOOKAHEAD);
+  printf("seq,time_us,position_m,velocity_mps,acceleration_mps2,throttle,target_mps,"
+         "engine,top_gear,brake,gas,cruise,cruising,degraded\n");
+  for (t = 0; t < duration; t += BUTTONIO_PERIOD) {
+    keys = replay_keys(t);
+    in.brake = keys == BRAKE_PEDAL_FLAG ? on : off;
+    in.driver.gas_pedal = keys == GAS_PEDAL_FLAG ? on : off;
+    if (keys == CRUISE_CONTROL_FLAG)
+      in.driver.cruise_control = in.driver.cruise_control == on ? off : on;
+    if (t % SWITCHIO_PERIOD == 0) {
+      in.driver.engine = (replay_switches(t) & ENGINE_FLAG) ? on : off;
+      in.driver.top_gear = (replay_switches(t) & TOP_GEAR_FLAG) ? on : off;
+    }
+    if (t % CONTROL_PERIOD != 0)
+      continue;
+
+    cl_step(&cl, &in);
+
+    /* the record of VehicleTask */
+    target = (cl.control.target + VM_ONE / 2) >> VM_FRAC_BITS;
+    r.seq = seq++;
+    r.flags = (in.driver.engine == on ? TEL_ENGINE : 0)
+            | (in.driver.top_gear == on ? TEL_TOP_GEAR : 0) | (in.brake == on ? TEL_BRAKE : 0)
+            | (in.driver.gas_pedal == on ? TEL_GAS : 0)
+            | (in.driver.cruise_control == on ? TEL_CRUISE : 0) | (target > 0 ? TEL_CRUISING : 0);
+    r.throttle = cl.throttle[0];
+    r.target = (INT8U)(target < 0 ? 0 : target > 255 ? 255 : target);
+    r.time = t * 1000UL;
+    r.position = (INT32U)((cl.vehicle.position >> (VM_POS_FRAC_BITS - 8)) * 100 >> 8);
+    r.velocity = q78(cl.vehicle.velocity);
+    r.acceleration = q78(cl.vehicle.acceleration);
+    printf("%u,%lu,%.2f,%.3f,%.3f,%u,%u,%d,%d,%d,%d,%d,%d,%d\n", r.seq,
+           (unsigned long)r.time, r.position / 100.0, r.velocity / 256.0,
+           r.acceleration / 256.0, r.throttle, r.target, !!(r.flags & TEL_ENGINE),
+           !!(r.flags & TEL_TOP_GEAR), !!(r.flags & TEL_BRAKE), !!(r.flags & TEL_GAS),
+           !!(r.flags & TEL_CRUISE), !!(r.flags & TEL_CRUISING), 0);
+  }
+  return 0;
+}
@@ -0,0 +1,46 @@
+/* Replay script to C table
+ *
+ * Description:
+ *
+ *   Reads a replay script (format in src/input_replay.h) and writes the
+ *   header that cruise_skeleton.c compiles in with INPUT_REPLAY:
+ *
+ *     usage: replay_gen script > ../src/replay_script.h
+ */
+#include <stdio.h>
+#include "input_replay.h"
+
+#define MAX_STATES 4096
+
+static replay_event script[MAX_STATES];
+
+int main(int argc, char **argv)
+{
+  int n, i;
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s script\n", argv[0]);
+    return 2;
+  }
+  n = replay_load(argv[1], script, MAX_STATES);
+  if (n < 0)
+    return 1;
+  if (n == 0) {
+    fprintf(stderr, "%s: no states\n", argv[1]);
+    return 1;
+  }
+
+  printf("/* Replay script for INPUT_REPLAY, see input_replay.h\n"
+         " *\n"
+         " * Generated by host/replay_gen from %s, do not edit.\n"
+         " */\n", argv[1]);
+  printf("#ifndef REPLAY_SCRIPT_H\n#define REPLAY_SCRIPT_H\n\n");
+  printf("#include \"input_replay.h\"\n\n");
+  printf("#define REPLAY_SCRIPT_LENGTH %d\n\n", n);
+  printf("static const replay_event replay_script[REPLAY_SCRIPT_LENGTH] = {\n");
+  for (i = 0; i < n; i++)
+    printf("  {%7lu, 0x%x, 0x%05lx},\n", (unsigned long)script[i].time, script[i].keys,
+           (unsigned long)script[i].switches);
+  printf("};\n\n#endif /* REPLAY_SCRIPT_H */\n");
+  return 0;
+}
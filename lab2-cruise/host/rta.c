@@ -0,0 +1,322 @@
+/* Response-time analysis of the cruise control task set
+ *
+ * Description:
+ *
+ *   Fixed-priority preemptive response-time analysis with release jitter
+ *   and blocking, for the task set declared in src/cruise_tasks.h:
+ *
+ *     w = C_i + B_i + sum_{j in hp(i)} ceil((w + J_j) / T_j) * C_j
+ *     R_i = w + J_i,  schedulable if R_i <= D_i
+ *
+ *   The execution times come from a file with one line per task:
+ *
+ *     <task> <wcet us> [<jitter us> [<blocking us>]]
+ *     extra <name> <priority> <period ms> <wcet us>
+ *
+ *   'extra' lines add load that is not in the task table, e.g. the timer
+ *   ISR. Tasks without a line are assumed to use their whole budget from
+ *   the task table, and are reported as such.
+ *
+ *   usage: rta [-r] [-x TASK] wcet-file
+ *
+ *   Besides the response time and slack of every task, the tool reports the
+ *   headroom of the task set: the factor by which all execution times can
+ *   grow, and the extra execution time TASK (default ExtraloadTask) can get
+ *   per period, before the first deadline is missed.
+ *
+ *   For the stages of CRUISE_PIPELINE it prints when each one is done after
+ *   the start of the period (release offset + response time), checks that
+ *   every stage is done before a later stage is released and that stages
+ *   released together run in order, and bounds the data age at actuation
+ *   by the time the last stage is done. The response times assume a
+ *   release together with all other tasks, so the bounds are safe with
+ *   offsets too.
+ *
+ *   -r analyses ControlTask and VehicleTask at the shortest period of the
+ *   adaptive control rate (RATE_MIN_PERIOD in control_rate.h), with the
+ *   deadline RATE_DEADLINE() gives them there: the worst case of
+ *   ADAPTIVE_RATE, whose longer periods only lower the load.
+ *
+ *   The exit status is 1 if the task set is not schedulable or the pipeline
+ *   runs out of order.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "cruise_tasks.h"
+#include "control_rate.h"
+
+#define RTA_MAX_TASKS 32
+
+typedef struct {
+  char   name[32];
+  int    prio;
+  double period;    /* all times in us */
+  double deadline;
+  double wcet;
+  double jitter;
+  double blocking;
+  double response;
+  int    measured;  /* wcet given in the file */
+} rta_task;
+
+static rta_task tasks[RTA_MAX_TASKS];
+static int n_tasks;
+
+#define TASK_ENTRY(name, period, deadline, budget, crit, stack) \
+  { #name, TASK_PRIO(name), (period) * 1000.0, (deadline) * 1000.0, budget, 0, 0, 0, 0 },
+static const rta_task table[] = { CRUISE_TASKS(TASK_ENTRY) };
+#undef TASK_ENTRY
+
+static rta_task *find_task(const char *name)
+{
+  int i;
+
+  for (i = 0; i < n_tasks; i++)
+    if (strcmp(tasks[i].name, name) == 0)
+      return &tasks[i];
+  return NULL;
+}
+
+static int load_wcet(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[256], name[32], extra[32];
+  double a, b, c;
+  int lineno = 0, n, prio;
+  rta_task *t;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    if (strchr(line, '#'))
+      *strchr(line, '#') = '\0';
+    if (sscanf(line, "%31s", name) != 1)
+      continue;
+
+    if (strcmp(name, "extra") == 0) {
+      n = sscanf(line, "%*s %31s %d %lf %lf", extra, &prio, &a, &b);
+      if (n != 4 || n_tasks == RTA_MAX_TASKS || a <= 0)
+        goto error;
+      t = &tasks[n_tasks++];
+      memset(t, 0, sizeof(*t));
+      snprintf(t->name, sizeof(t->name), "%s", extra);
+      t->prio = prio;
+      t->period = t->deadline = a * 1000.0;
+      t->wcet = b;
+      t->measured = 1;
+      continue;
+    }
+
+    t = find_task(name);
+    b = c = 0;
+    n = sscanf(line, "%*s %lf %lf %lf", &a, &b, &c);
+    if (t == NULL || n < 1)
+      goto error;
+    t->wcet = a;
+    t->jitter = b;
+    t->blocking = c;
+    t->measured = 1;
+  }
+  fclose(f);
+  return 0;
+
+error:
+  fprintf(stderr, "%s:%d: unknown task or syntax error\n", path, lineno);
+  fclose(f);
+  return -1;
+}
+
+static int by_prio(const void *a, const void *b)
+{
+  return ((const rta_task *)a)->prio - ((const rta_task *)b)->prio;
+}
+
+/*
+ * Computes the response times with every wcet scaled by 'scale' and 'extra'
+ * us added to task 'x'. Returns 1 if every deadline is met.
+ */
+static int analyse(double scale, const rta_task *x, double extra)
+{
+  int i, j, ok = 1;
+
+  for (i = 0; i < n_tasks; i++) {
+    rta_task *t = &tasks[i];
+    double c = t->wcet * scale + (t == x ? extra : 0);
+    double w = c + t->blocking, prev = -1;
+
+    while (w != prev && w + t->jitter <= t->deadline) {
+      prev = w;
+      w = c + t->blocking;
+      for (j = 0; j < i; j++) {
+        double cj = tasks[j].wcet * scale + (&tasks[j] == x ? extra : 0);
+        w += ceil((prev + tasks[j].jitter) / tasks[j].period) * cj;
+      }
+    }
+    t->response = w + t->jitter;
+    if (t->response > t->deadline)
+      ok = 0;
+  }
+  return ok;
+}
+
+/* largest x in [lo, hi] with ok(x), assuming monotonicity */
+static double search(double lo, double hi, const rta_task *x, int scale_mode)
+{
+  int k;
+
+  for (k = 0; k < 60; k++) {
+    double mid = (lo + hi) / 2;
+    int ok = scale_mode ? analyse(mid, NULL, 0) : analyse(1.0, x, mid);
+
+    if (ok)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+typedef struct {
+  const char *name;
+  int offset; /* [ms] */
+} rta_stage;
+
+#define STAGE_ENTRY(name, offset) { #name, offset },
+static const rta_stage stages[] = { CRUISE_PIPELINE(STAGE_ENTRY) };
+#undef STAGE_ENTRY
+
+/* Prints the pipeline stages, returns 1 if they run in order */
+static int pipeline(void)
+{
+  const int n = sizeof(stages) / sizeof(stages[0]);
+  double done[sizeof(stages) / sizeof(stages[0])], age = 0;
+  int i, j, ok = 1;
+
+  printf("pipeline:\n");
+  for (i = 0; i < n; i++) {
+    rta_task *t = find_task(stages[i].name);
+
+    done[i] = stages[i].offset * 1000.0 + t->response;
+    if (done[i] > age)
+      age = done[i];
+    printf("  %-18s offset %4d ms, done by %9.0f us", t->name, stages[i].offset, done[i]);
+    for (j = 0; j < i; j++) {
+      rta_task *u = find_task(stages[j].name);
+
+      if (stages[j].offset < stages[i].offset && done[j] > stages[i].offset * 1000.0) {
+        printf(", LATE: %s not done", u->name);
+        ok = 0;
+      } else if (stages[j].offset == stages[i].offset && u->prio > t->prio) {
+        printf(", OUT OF ORDER: runs before %s", u->name);
+        ok = 0;
+      } else if (stages[j].offset > stages[i].offset) {
+        printf(", OUT OF ORDER: released before %s", u->name);
+        ok = 0;
+      }
+    }
+    printf("\n");
+  }
+  printf("pipeline: data age at actuation <= %.0f us%s\n", age, ok ? "" : " (stages out of order)");
+  return ok;
+}
+
+/* ControlTask and VehicleTask at the shortest adaptive period */
+static void fastest_rate(void)
+{
+  rta_task *t;
+
+  t = find_task("ControlTask");
+  t->period = RATE_MIN_PERIOD * 1000.0;
+  t->deadline = RATE_DEADLINE(ControlTask_deadline, RATE_MIN_PERIOD) * 1000.0;
+  t = find_task("VehicleTask");
+  t->period = RATE_MIN_PERIOD * 1000.0;
+  t->deadline = RATE_DEADLINE(VehicleTask_deadline, RATE_MIN_PERIOD) * 1000.0;
+  printf("ControlTask and VehicleTask at the fastest adaptive rate, %d ms\n", RATE_MIN_PERIOD);
+}
+
+static long gcd(long a, long b)
+{
+  while (b) {
+    long t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+int main(int argc, char **argv)
+{
+  const char *extra_name = "ExtraloadTask";
+  rta_task *x;
+  double util = 0, scale, extra;
+  long hyper = 1;
+  int i, opt, ok, rate = 0;
+
+  while ((opt = getopt(argc, argv, "rx:")) != -1) {
+    if (opt == 'x') {
+      extra_name = optarg;
+    } else if (opt == 'r') {
+      rate = 1;
+    } else {
+      fprintf(stderr, "usage: %s [-r] [-x TASK] wcet-file\n", argv[0]);
+      return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-r] [-x TASK] wcet-file\n", argv[0]);
+    return 2;
+  }
+
+  n_tasks = sizeof(table) / sizeof(table[0]);
+  memcpy(tasks, table, sizeof(table));
+  if (load_wcet(argv[optind]) < 0)
+    return 2;
+  if (rate)
+    fastest_rate();
+  qsort(tasks, n_tasks, sizeof(rta_task), by_prio);
+
+  for (i = 0; i < n_tasks; i++) {
+    if (i > 0 && tasks[i].prio == tasks[i - 1].prio)
+      printf("warning: %s and %s share priority %d\n", tasks[i - 1].name, tasks[i].name, tasks[i].prio);
+    if (!tasks[i].measured)
+      printf("warning: no execution time for %s, using its budget of %.0f us\n", tasks[i].name,
+          tasks[i].wcet);
+    util += tasks[i].wcet / tasks[i].period;
+    hyper = hyper / gcd(hyper, (long)tasks[i].period) * (long)tasks[i].period;
+  }
+  if (hyper != HYPERPERIOD * 1000L)
+    printf("warning: HYPERPERIOD is %d ms, the periods give %ld ms\n", HYPERPERIOD, hyper / 1000);
+
+  ok = analyse(1.0, NULL, 0);
+  printf("%-18s %4s %8s %8s %8s %7s %7s %9s %9s  %s\n", "task", "prio", "T[ms]", "D[ms]",
+      "C[us]", "J[us]", "B[us]", "R[us]", "slack[us]", "ok");
+  for (i = 0; i < n_tasks; i++) {
+    rta_task *t = &tasks[i];
+
+    printf("%-18s %4d %8.0f %8.0f %8.0f %7.0f %7.0f %9.0f %9.0f  %s\n", t->name, t->prio,
+        t->period / 1000, t->deadline / 1000, t->wcet, t->jitter, t->blocking, t->response,
+        t->deadline - t->response, t->response <= t->deadline ? "yes" : "NO");
+  }
+  printf("utilization %.2f %%, hyperperiod %ld ms: %s\n", util * 100, hyper / 1000,
+      ok ? "schedulable" : "NOT schedulable");
+
+  if (ok) {
+    scale = search(1.0, 1000.0, NULL, 1);
+    printf("headroom: all execution times x %.2f (utilization %.2f %%)\n", scale, util * scale * 100);
+    x = find_task(extra_name);
+    if (x != NULL) {
+      extra = search(0, x->deadline, x, 0);
+      printf("headroom: %s +%.0f us per %.0f ms (+%.2f %% utilization)\n", x->name, extra,
+          x->period / 1000, extra / x->period * 100);
+    }
+    analyse(1.0, NULL, 0);
+    ok = pipeline();
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+/* Decoder of the telemetry stream of the board
+ *
+ * Description:
+ *
+ *   Reads the frames written by tel_flush() (src/telemetry.h), e.g. the
+ *   captured output of nios2-terminal, from a file or stdin and prints one
+ *   CSV line per record:
+ *
+ *     seq,time_us,position_m,velocity_mps,acceleration_mps2,throttle,
+ *     target_mps,engine,top_gear,brake,gas,cruise,cruising,degraded
+ *
+ *   The time is unwrapped to 64 bit. Bytes that are not part of a frame
+ *   (text printed on the same channel) are skipped; records missing from
+ *   the stream are counted as a gap. A summary goes to stderr.
+ *
+ *   usage: tel_decode [file]
+ */
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+
+#define BUF_SIZE 4096
+
+int main(int argc, char **argv)
+{
+  static INT8U buf[BUF_SIZE];
+  FILE *f = stdin;
+  tel_record r, prev;
+  INT64U time = 0;
+  long records = 0, skipped = 0, gaps = 0;
+  int len = 0, pos, n, have_prev = 0, eof = 0;
+
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [file]\n", argv[0]);
+    return 2;
+  }
+  if (argc == 2 && (f = fopen(argv[1], "rb")) == NULL) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  printf("seq,time_us,position_m,velocity_mps,acceleration_mps2,throttle,target_mps,"
+         "engine,top_gear,brake,gas,cruise,cruising,degraded\n");
+  while (!eof || len > 0) {
+    if (!eof && len < BUF_SIZE) {
+      n = (int)fread(buf + len, 1, BUF_SIZE - len, f);
+      if (n == 0)
+        eof = 1;
+      len += n;
+    }
+    pos = 0;
+    while (pos < len) {
+      n = tel_decode(buf + pos, len - pos, have_prev ? &prev : NULL, &r);
+      if (n == 0 && !eof)
+        break;
+      if (n <= 0) {
+        pos++;
+        skipped++;
+        continue;
+      }
+      if (have_prev) {
+        time += r.time - prev.time;
+        if (r.seq != (INT8U)(prev.seq + 1))
+          gaps++;
+      } else {
+        time = r.time;
+      }
+      printf("%u,%llu,%.2f,%.3f,%.3f,%u,%u,%d,%d,%d,%d,%d,%d,%d\n", r.seq,
+             (unsigned long long)time, r.position / 100.0, r.velocity / 256.0,
+             r.acceleration / 256.0, r.throttle, r.target, !!(r.flags & TEL_ENGINE),
+             !!(r.flags & TEL_TOP_GEAR), !!(r.flags & TEL_BRAKE), !!(r.flags & TEL_GAS),
+             !!(r.flags & TEL_CRUISE), !!(r.flags & TEL_CRUISING), !!(r.flags & TEL_DEGRADED));
+      prev = r;
+      have_prev = 1;
+      records++;
+      pos += n;
+    }
+    memmove(buf, buf + pos, len - pos);
+    len -= pos;
+  }
+  fprintf(stderr, "%ld records, %ld gaps, %ld bytes skipped\n", records, gaps, skipped);
+  if (f != stdin)
+    fclose(f);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/* Adaptive control rate, see control_rate.h */
+#include <stdio.h>
+#include "control_rate.h"
+
+static const INT16U periods[RATE_LEVELS] = RATE_PERIODS;
+
+void rate_init(control_rate *r)
+{
+  int i;
+
+  r->level = RATE_DEFAULT_LEVEL;
+  r->calm = 0;
+  r->inputs = 0;
+  r->prev_velocity = 0;
+  r->reason = RATE_NORMAL;
+  r->changes = 0;
+  for (i = 0; i < RATE_LEVELS; i++)
+    r->level_ms[i] = 0;
+}
+
+static INT32S magnitude(INT32S x)
+{
+  return x < 0 ? -x : x;
+}
+
+INT16U rate_update(control_rate *r, const cruise_inputs *in, enum active brake,
+                   const cruise_ctl *c, INT32S velocity)
+{
+  INT8U inputs = (in->gas_pedal == on) | (brake == on) << 1 | (in->cruise_control == on) << 2
+               | (in->engine == on) << 3 | (in->top_gear == on) << 4;
+  INT32S error = c->cruising ? magnitude(c->target - velocity) : 0;
+  INT32S accel = (INT32S)((INT64S)magnitude(velocity - r->prev_velocity) * 1000 / periods[r->level]);
+  INT8U level = r->level;
+  enum rate_reason reason;
+
+  r->level_ms[r->level] += periods[r->level];
+  if (inputs != r->inputs || in->gas_pedal == on || brake == on || error > RATE_ERROR_HIGH) {
+    level = 0;
+    reason = RATE_ACTIVE;
+  } else if (in->engine == off && magnitude(velocity) < RATE_PARKED) {
+    level = RATE_LEVELS - 1;
+    reason = RATE_STOPPED;
+  } else if (in->engine == on && error < RATE_ERROR_LOW && accel < RATE_ACCEL_LOW) {
+    reason = RATE_STEADY;
+    if (++r->calm >= RATE_CALM && level < RATE_MAX_RUNNING)
+      level++;
+  } else {
+    reason = RATE_NORMAL;
+    r->calm = 0;
+    if (level > RATE_DEFAULT_LEVEL)
+      level = RATE_DEFAULT_LEVEL;
+  }
+  r->inputs = inputs;
+  r->prev_velocity = velocity;
+  if (level != r->level) {
+    r->level = level;
+    r->calm = 0;
+    r->reason = reason;
+    r->changes++;
+  }
+  return periods[r->level];
+}
+
+INT16U rate_period(const control_rate *r)
+{
+  return periods[r->level];
+}
+
+const char *rate_reason_name(enum rate_reason reason)
+{
+  static const char *names[] = {"active", "steady", "parked", "normal"};
+
+  return names[reason];
+}
+
+void rate_print(const control_rate *r)
+{
+  INT32U total = 0;
+  int i;
+
+  for (i = 0; i < RATE_LEVELS; i++)
+    total += r->level_ms[i];
+  printf("rate: %u ms now, %lu changes, time per period:", periods[r->level], (unsigned long)r->changes);
+  for (i = 0; i < RATE_LEVELS; i++)
+    printf(" %u ms %lu%%", periods[i], total ? (unsigned long)((INT64U)r->level_ms[i] * 100 / total) : 0UL);
+  printf("\n");
+}
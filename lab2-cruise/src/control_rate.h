@@ -0,0 +1,73 @@
+/* Adaptive control rate
+ *
+ * Description:
+ *
+ *   Chooses the period of ControlTask and VehicleTask from the state of
+ *   the drive, on a ladder of RATE_LEVELS periods:
+ *
+ *     active  a pedal or the cruise switch changed, the gas or the brake
+ *             is pressed, or the velocity is more than RATE_ERROR_HIGH off
+ *             the cruise target: the shortest period, at once;
+ *     steady  engine on, velocity within RATE_ERROR_LOW of the target (or
+ *             not cruising) and changing by less than RATE_ACCEL_LOW: one
+ *             level longer after RATE_CALM steps, up to RATE_MAX_RUNNING;
+ *     parked  engine off below RATE_PARKED: the longest period;
+ *     else    back to RATE_DEFAULT_LEVEL if the period is longer.
+ *
+ *   rate_update() is called once per control step and returns the period
+ *   until the next one. The levels are multiples of the ButtonIO period, so
+ *   every control step sees fresh inputs. rate_print() sums up the time
+ *   spent at every level.
+ *
+ *   The task table and rta assume CONTROL_PERIOD. At a level shorter than
+ *   that both tasks are released more often and RATE_DEADLINE() keeps
+ *   their deadline within the period, after the pipeline offset; the task
+ *   monitor follows the current limits (tm_set_period()). 'rta -r'
+ *   analyses the task set at RATE_MIN_PERIOD, the worst case for the CPU
+ *   demand of the loop.
+ */
+#ifndef CONTROL_RATE_H
+#define CONTROL_RATE_H
+
+#include "cruise_types.h"
+#include "cruise_control.h"
+#include "vehicle_model.h"
+#include "cruise_tasks.h"
+
+#define RATE_LEVELS        5
+#define RATE_PERIODS       {100, 200, 300, 600, 1200} /* [ms] */
+#define RATE_MIN_PERIOD    100                         /* [ms], the first of RATE_PERIODS */
+#define RATE_DEFAULT_LEVEL 2
+#define RATE_DEFAULT_PERIOD 300                        /* [ms], the fixed CONTROL_PERIOD */
+#define RATE_MAX_RUNNING   3                           /* highest level with the engine on */
+#define RATE_ERROR_HIGH    VM_FROM_INT(1)              /* Q15.16 [m/s] */
+#define RATE_ERROR_LOW     (VM_ONE / 4)                /* Q15.16 [m/s] */
+#define RATE_ACCEL_LOW     (VM_ONE / 4)                /* Q15.16 [m/s^2] */
+#define RATE_PARKED        VM_ONE                      /* Q15.16 [m/s] */
+#define RATE_CALM          5                           /* steps */
+
+/* Deadline [ms] of a loop task with table deadline 'deadline' at 'period' */
+#define RATE_DEADLINE(deadline, period) \
+  ((deadline) < (period) - PIPELINE_OFFSET ? (deadline) : (period) - PIPELINE_OFFSET)
+
+enum rate_reason {RATE_ACTIVE, RATE_STEADY, RATE_STOPPED, RATE_NORMAL};
+
+typedef struct {
+  INT8U  level;
+  INT8U  calm;           /* steady steps at this level */
+  INT8U  inputs;         /* pedal and switch bits of the last step */
+  INT32S prev_velocity;  /* Q15.16 [m/s] */
+  enum rate_reason reason;  /* of the last change */
+  INT32U changes;
+  INT32U level_ms[RATE_LEVELS];  /* time spent at every level */
+} control_rate;
+
+void   rate_init(control_rate *r);
+/* Period until the next step [ms] */
+INT16U rate_update(control_rate *r, const cruise_inputs *in, enum active brake,
+                   const cruise_ctl *c, INT32S velocity);
+INT16U rate_period(const control_rate *r);
+const char *rate_reason_name(enum rate_reason reason);
+void   rate_print(const control_rate *r);
+
+#endif /* CONTROL_RATE_H */
@@ -0,0 +1,189 @@
+/* Per-task CPU time accounting, see cpu_account.h */
+#include <stdio.h>
+#include <string.h>
+#include "cpu_account.h"
+#include "cruise_clock.h"
+#include "cruise_tasks.h"
+
+#define CPU_SLOTS (OS_LOWEST_PRIO + 1 + CPU_ISR_COUNT) /* tasks by priority, then ISRs */
+#define CPU_ISR_SLOT(isr) (OS_LOWEST_PRIO + 1 + (isr))
+
+static INT32U busy[CPU_SLOTS];    /* cycles in the current window */
+static INT32U used[OS_LOWEST_PRIO + 1]; /* cycles since boot, by priority */
+static INT32U last_switch;        /* start of the running interval */
+static INT32U window_start;
+static INT32U isr_start;
+static INT8U isr_nesting;
+
+static INT16U load[CPU_WINDOWS][CPU_SLOTS]; /* per mille */
+static INT8U window;                        /* next entry of load[] */
+static INT8U windows_done;
+
+void cpu_account_init(void)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  memset(busy, 0, sizeof(busy));
+  memset(used, 0, sizeof(used));
+  memset(load, 0, sizeof(load));
+  window = windows_done = 0;
+  isr_nesting = 0;
+  last_switch = window_start = cruise_clock_cycles();
+  OS_EXIT_CRITICAL();
+#if OS_APP_HOOKS_EN == 0
+  printf("cpu_account: no task switch hook, set OS_APP_HOOKS_EN\n");
+#endif
+}
+
+/* Charges the running interval to the task that is switched out */
+static void charge_current(INT32U now)
+{
+  busy[OSTCBCur->OSTCBPrio] += now - last_switch;
+  used[OSTCBCur->OSTCBPrio] += now - last_switch;
+  last_switch = now;
+}
+
+/* Called with interrupts disabled */
+void cpu_isr_enter(void)
+{
+  if (isr_nesting++ == 0)
+    isr_start = cruise_clock_cycles();
+}
+
+void cpu_isr_exit(enum cpu_isr isr)
+{
+  INT32U d;
+
+  if (--isr_nesting != 0)
+    return;
+  d = cruise_clock_cycles() - isr_start;
+  busy[CPU_ISR_SLOT(isr)] += d;
+  last_switch += d; /* not charged to the interrupted task */
+}
+
+void cpu_window(void)
+{
+  INT32U now, total;
+  INT32U cycles[CPU_SLOTS];
+  int i;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  now = cruise_clock_cycles();
+  charge_current(now);
+  memcpy(cycles, busy, sizeof(cycles));
+  memset(busy, 0, sizeof(busy));
+  total = now - window_start;
+  window_start = now;
+  OS_EXIT_CRITICAL();
+
+  for (i = 0; i < CPU_SLOTS; i++)
+    load[window][i] = total ? (INT16U)((INT64U)cycles[i] * 1000 / total) : 0;
+  window = (window + 1) % CPU_WINDOWS;
+  if (windows_done < CPU_WINDOWS)
+    windows_done++;
+}
+
+INT32U cpu_self_cycles(void)
+{
+#if OS_APP_HOOKS_EN > 0
+  INT32U cycles;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  cycles = used[OSTCBCur->OSTCBPrio] + (cruise_clock_cycles() - last_switch);
+  OS_EXIT_CRITICAL();
+  return cycles;
+#else
+  return cruise_clock_cycles();
+#endif
+}
+
+static INT16U average(int slot, INT8U windows)
+{
+  INT32U sum = 0;
+  int i, w;
+
+  if (windows > windows_done)
+    windows = windows_done;
+  if (windows == 0)
+    return 0;
+  for (i = 1, w = window; i <= windows; i++) {
+    w = (w + CPU_WINDOWS - 1) % CPU_WINDOWS;
+    sum += load[w][slot];
+  }
+  return (INT16U)(sum / windows);
+}
+
+INT16U cpu_load(INT8U prio, INT8U windows)
+{
+  return prio <= OS_LOWEST_PRIO ? average(prio, windows) : 0;
+}
+
+INT16U cpu_isr_load(enum cpu_isr isr, INT8U windows)
+{
+  return average(CPU_ISR_SLOT(isr), windows);
+}
+
+#define CPU_PRINT_TASK(name, period, deadline, budget, crit, stack)           \
+  l = cpu_load(TASK_PRIO(name), windows);                                     \
+  tasks += l;                                                                 \
+  printf(" %s %u.%u", #name, l / 10, l % 10);
+
+void cpu_print(INT8U windows)
+{
+  INT16U l, tasks = 0, idle = cpu_load(OS_LOWEST_PRIO, windows), isr = 0, other;
+  int i;
+
+  printf("cpu%%:");
+  CRUISE_TASKS(CPU_PRINT_TASK)
+  for (i = 0; i < CPU_ISR_COUNT; i++)
+    isr += cpu_isr_load(i, windows);
+  other = 1000 - tasks - isr - idle;
+  if (tasks + isr + idle > 1000)
+    other = 0;
+  printf(" isr %u.%u other %u.%u idle %u.%u\n", isr / 10, isr % 10, other / 10, other % 10,
+         idle / 10, idle % 10);
+}
+#undef CPU_PRINT_TASK
+
+#if OS_APP_HOOKS_EN > 0
+/*
+ * uC/OS-II application hooks, only the switch hook is used
+ */
+void App_TaskSwHook(void)
+{
+  charge_current(cruise_clock_cycles());
+}
+
+void App_TaskCreateHook(OS_TCB *ptcb)
+{
+}
+
+void App_TaskDelHook(OS_TCB *ptcb)
+{
+}
+
+void App_TaskIdleHook(void)
+{
+}
+
+void App_TaskStatHook(void)
+{
+}
+
+void App_TCBInitHook(OS_TCB *ptcb)
+{
+}
+
+void App_TimeTickHook(void)
+{
+}
+#endif
@@ -0,0 +1,49 @@
+/* Per-task CPU time accounting
+ *
+ * Description:
+ *
+ *   The context switch hook (App_TaskSwHook, needs OS_APP_HOOKS_EN) charges
+ *   the cycles since the previous switch to the task that was running, by
+ *   priority. ISRs that call cpu_isr_enter()/cpu_isr_exit() are charged to
+ *   their own slot instead of the task they interrupted. The idle task is
+ *   the slot of OS_LOWEST_PRIO.
+ *
+ *   cpu_window() closes a measurement window (WatchdogTask does it every
+ *   hyperperiod); the loads of the last CPU_WINDOWS windows are kept, so
+ *   cpu_load() can average over a sliding window of up to CPU_WINDOWS.
+ *   Loads are in per mille.
+ *
+ *   cpu_self_cycles() is the CPU time the calling task got so far, without
+ *   preemption and the accounted ISRs; the difference of two readings is
+ *   what the task itself executed in between. Without the switch hook it
+ *   falls back to cruise_clock_cycles(), i.e. includes preemption.
+ *
+ *   The hook costs one counter read and two additions per switch.
+ */
+#ifndef CPU_ACCOUNT_H
+#define CPU_ACCOUNT_H
+
+#include "cruise_types.h"
+
+#define CPU_WINDOWS 10
+
+enum cpu_isr {
+  CPU_ISR_TIMER, /* alarm_handler / high resolution timer */
+  CPU_ISR_COUNT
+};
+
+void cpu_account_init(void);
+void cpu_isr_enter(void);
+void cpu_isr_exit(enum cpu_isr isr);
+void cpu_window(void);
+/* Cycles charged to the calling task so far, wraps like cruise_clock_cycles() */
+INT32U cpu_self_cycles(void);
+
+/* Load [per mille] of priority 'prio' / ISR 'isr' over the last 'windows' windows */
+INT16U cpu_load(INT8U prio, INT8U windows);
+INT16U cpu_isr_load(enum cpu_isr isr, INT8U windows);
+
+/* One line with the load of every task, the ISRs and idle */
+void cpu_print(INT8U windows);
+
+#endif /* CPU_ACCOUNT_H */
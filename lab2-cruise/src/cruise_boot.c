@@ -0,0 +1,34 @@
+/* Boot timeline, see cruise_boot.h */
+#include <stdio.h>
+#include "cruise_boot.h"
+#include "cruise_clock.h"
+
+#define BOOT_STAGE_TEXT(id, text) text,
+static const char *const boot_text[BOOT_STAGE_COUNT] = { BOOT_STAGES(BOOT_STAGE_TEXT) };
+#undef BOOT_STAGE_TEXT
+
+static INT32U boot_time[BOOT_STAGE_COUNT];
+static INT8U boot_seen[BOOT_STAGE_COUNT];
+
+int boot_mark(enum boot_stage stage)
+{
+  if (boot_seen[stage])
+    return 0;
+  boot_time[stage] = cruise_clock_us();
+  boot_seen[stage] = 1;
+  return 1;
+}
+
+void boot_print(void)
+{
+  int i;
+
+  printf("boot timeline [us]:\n");
+  for (i = 0; i < BOOT_STAGE_COUNT; i++) {
+    if (boot_seen[i])
+      printf("  %8lu %8lu  %s\n", (unsigned long)boot_time[i],
+             (unsigned long)(boot_time[i] - boot_time[BOOT_START]), boot_text[i]);
+    else
+      printf("  %8s %8s  %s\n", "-", "-", boot_text[i]);
+  }
+}
@@ -0,0 +1,33 @@
+/* Boot timeline
+ *
+ * Description:
+ *
+ *   StartTask and ControlTask mark the stages of the boot with
+ *   boot_mark(); boot_print() lists when each stage was reached, in us on
+ *   the cruise_clock time base. The clock starts in StartTask, so the time
+ *   from reset to StartTask (HAL init, OSInit, OSStart) is not included.
+ */
+#ifndef CRUISE_BOOT_H
+#define CRUISE_BOOT_H
+
+#include "cruise_types.h"
+
+/*
+ * X(id, description) in the order they are reached
+ */
+#define BOOT_STAGES(X)                                   \
+  X(BOOT_START,         "StartTask running")             \
+  X(BOOT_OBJECTS,       "semaphores, mailboxes, topics") \
+  X(BOOT_TASKS,         "tasks created")                 \
+  X(BOOT_TIMERS,        "alarm and timers started")      \
+  X(BOOT_FIRST_CONTROL, "first ControlTask output")
+
+#define BOOT_STAGE_ID(id, text) id,
+enum boot_stage { BOOT_STAGES(BOOT_STAGE_ID) BOOT_STAGE_COUNT };
+#undef BOOT_STAGE_ID
+
+/* Records the time of 'stage'; returns 1 the first time, 0 afterwards */
+int boot_mark(enum boot_stage stage);
+void boot_print(void);
+
+#endif /* CRUISE_BOOT_H */
@@ -0,0 +1,51 @@
+/* Free running time base, see cruise_clock.h */
+#include "cruise_clock.h"
+
+#ifdef CRUISE_HOST
+
+#include <time.h>
+
+void cruise_clock_init(void)
+{
+}
+
+INT32U cruise_clock_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (INT32U)((unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+INT32U cruise_clock_cycles(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (INT32U)((unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#else
+
+#include "system.h"
+#include "altera_avalon_performance_counter.h"
+
+#define CYCLES_PER_US (ALT_CPU_FREQ / 1000000)
+
+void cruise_clock_init(void)
+{
+  PERF_RESET(PERFORMANCE_COUNTER_BASE);
+  PERF_START_MEASURING(PERFORMANCE_COUNTER_BASE);
+}
+
+INT32U cruise_clock_us(void)
+{
+  return (INT32U)(perf_get_total_time((void *)PERFORMANCE_COUNTER_BASE) / CYCLES_PER_US);
+}
+
+INT32U cruise_clock_cycles(void)
+{
+  return (INT32U)perf_get_total_time((void *)PERFORMANCE_COUNTER_BASE);
+}
+
+#endif
@@ -0,0 +1,34 @@
+/* Free running time base for the cruise control application
+ *
+ * Description:
+ *
+ *   On the board the global interval of the performance counter is started
+ *   once at boot and never reset, so it can serve as a microsecond clock for
+ *   latency and execution time measurements. Sections 1..3 of the counter are
+ *   still available for PERF_BEGIN/PERF_END measurements.
+ *   On the host (CRUISE_HOST) the monotonic clock of the OS is used instead.
+ *
+ *   The returned value wraps after about 71 minutes, so only differences of
+ *   two readings (computed in unsigned arithmetic) are meaningful.
+ *
+ *   cruise_clock_cycles() is the raw counter at CRUISE_CLOCK_HZ for places
+ *   where a division is too expensive (context switch hook); it wraps after
+ *   about 85 s on the board.
+ */
+#ifndef CRUISE_CLOCK_H
+#define CRUISE_CLOCK_H
+
+#include "cruise_types.h"
+
+#ifdef CRUISE_HOST
+#define CRUISE_CLOCK_HZ 1000000000UL /* ns */
+#else
+#include "system.h"
+#define CRUISE_CLOCK_HZ ALT_CPU_FREQ
+#endif
+
+void   cruise_clock_init(void);
+INT32U cruise_clock_us(void);
+INT32U cruise_clock_cycles(void);
+
+#endif /* CRUISE_CLOCK_H */
@@ -0,0 +1,121 @@
+/* Control law of the cruise control, see cruise_control.h */
+#include <stddef.h>
+#include "cruise_control.h"
+#include "gain_table.h"
+#include "throttle_table.h"
+#include "vehicle_model.h"
+
+void cruise_ctl_init(cruise_ctl *c, INT16U period_ms)
+{
+  c->cruising = 0;
+  c->target = 0;
+  c->throttle = 0;
+  c->feedforward = 0;
+  c->ff_track = NULL;
+  c->ff_lookahead = 0;
+  c->kp_period = CRUISE_KP_PERIOD;
+  c->ti = CRUISE_TI;
+  c->kd = CRUISE_KD;
+  pid_init(&c->pid, 0, 0, CRUISE_KD, period_ms, 0, VM_FROM_INT(VM_MAX_THROTTLE));
+  cruise_ctl_set_period(c, period_ms);
+}
+
+/*
+ * Adapts the gains to a new control period, see CRUISE_KP_PERIOD
+ */
+void cruise_ctl_set_period(cruise_ctl *c, INT16U period_ms)
+{
+  INT32S kp = (INT32S)(((INT64S)c->kp_period * 1000 + period_ms / 2) / period_ms);
+  INT32S ki = (INT32S)(((INT64S)kp * 1000 + c->ti / 2) / c->ti);
+
+  pid_set_period(&c->pid, period_ms);
+  pid_set_gains(&c->pid, kp, ki, c->kd);
+}
+
+void cruise_ctl_set_gains(cruise_ctl *c, INT32S kp_period, INT16U ti_ms, INT32S kd)
+{
+  c->kp_period = kp_period;
+  c->ti = ti_ms;
+  c->kd = kd;
+  cruise_ctl_set_period(c, c->pid.period);
+}
+
+void cruise_ctl_set_target(cruise_ctl *c, INT32S target)
+{
+  if (c->cruising)
+    c->target = target;
+}
+
+void cruise_ctl_set_feedforward(cruise_ctl *c, const track *t, INT16U lookahead_ms)
+{
+  c->ff_track = t;
+  c->ff_lookahead = lookahead_ms;
+}
+
+/*
+ * Throttle outside of cruise mode, interpolated from the gain schedules
+ * (constant time, saturates outside of -5..80 m/s)
+ */
+static INT8U calculate_throttle(INT32S velocity, enum active gas_pedal)
+{
+  const gain_table *t = (gas_pedal == on) ? &throttle_speed_up : &throttle_slow_down;
+
+  return (INT8U)((gs_lookup(t, velocity) + GS_ONE / 2) >> GS_FRAC_BITS);
+}
+
+/*
+ * Throttle that holds the velocity on the slope ahead: one unit of throttle
+ * accelerates the vehicle by 1 m/s^2 (vehicle_model.c), so it is the
+ * acceleration by gravity negated. The PI controller gets the rest of the
+ * throttle range, so its anti-windup still works at the real limits.
+ */
+static void update_feedforward(cruise_ctl *c, INT32S velocity, INT32U position)
+{
+  INT32U ahead = 0;
+
+  c->feedforward = 0;
+  if (c->ff_track != NULL) {
+    if (velocity > 0)
+      ahead = (INT32U)(((INT64S)velocity * c->ff_lookahead / 1000) >> VM_FRAC_BITS);
+    c->feedforward = -track_slope(c->ff_track, position + ahead);
+  }
+  pid_set_limits(&c->pid, -c->feedforward, VM_FROM_INT(VM_MAX_THROTTLE) - c->feedforward);
+}
+
+static INT8U calculate_cruise(cruise_ctl *c, INT32S velocity)
+{
+  INT32S u = pid_update(&c->pid, c->target, velocity) + c->feedforward;
+
+  return (INT8U)((u + VM_ONE / 2) >> VM_FRAC_BITS);
+}
+
+/*
+ * One control period: returns the throttle (0..80) for 'velocity' (Q15.16)
+ * at 'position' [m]
+ */
+INT8U cruise_ctl_step(cruise_ctl *c, const cruise_inputs *in, INT32S velocity, INT32U position)
+{
+  INT8U throttle;
+
+  if (in->cruise_control == on && !c->cruising && in->top_gear == on
+      && velocity > VM_FROM_INT(CRUISE_MIN_VELOCITY)) {
+    c->cruising = 1;
+    c->target = velocity;
+    // bumpless transfer: continue from the throttle applied so far
+    update_feedforward(c, velocity, position);
+    pid_reset(&c->pid, velocity, VM_FROM_INT(c->throttle) - c->feedforward);
+    throttle = calculate_cruise(c, velocity);
+  } else if (c->cruising && in->top_gear == on && in->cruise_control == on) {
+    update_feedforward(c, velocity, position);
+    throttle = calculate_cruise(c, velocity);
+  } else if (in->engine == on) {
+    throttle = calculate_throttle(velocity, in->gas_pedal);
+    c->target = 0;
+    c->cruising = 0;
+  } else {
+    throttle = 0;
+  }
+
+  c->throttle = throttle;
+  return throttle;
+}
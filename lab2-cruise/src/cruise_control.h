@@ -0,0 +1,73 @@
+/* Control law of the cruise control
+ *
+ * Description:
+ *
+ *   Computes the throttle from the driver inputs and the velocity, once per
+ *   control period. Outside of cruise mode the throttle comes from the gain
+ *   schedules of throttle_table.c. Cruise mode is entered when the cruise
+ *   control is switched on in top gear above CRUISE_MIN_VELOCITY; the current
+ *   velocity then becomes the target and a PI controller (cruise_pid.c) takes
+ *   over from the throttle applied so far.
+ *
+ *   With a track set by cruise_ctl_set_feedforward(), the throttle that
+ *   holds the speed on the slope ahead of the vehicle is added to the
+ *   output of the PI controller while cruising, so it only has to correct
+ *   what the track profile does not predict instead of reacting to a hill
+ *   once it has slowed the vehicle down. The slope is looked up 'lookahead'
+ *   ms ahead at the current velocity.
+ *
+ *   The module has no RTOS dependencies, ControlTask and the host tools run
+ *   the same code.
+ */
+#ifndef CRUISE_CONTROL_H
+#define CRUISE_CONTROL_H
+
+#include "cruise_types.h"
+#include "cruise_pid.h"
+#include "track.h"
+
+#define CRUISE_MIN_VELOCITY 25 /* [m/s] */
+
+/*
+ * Tuning of the cruise controller: CRUISE_KP_PERIOD, CRUISE_TI and CRUISE_KD
+ * come from cruise_gains.h, generated by host/autotune for the pipeline
+ * of CRUISE_PIPELINE, where the throttle is applied in the period it was
+ * computed. The vehicle integrates it over one period, so the velocity
+ * correction per step grows with kp * period; for the same damping at any
+ * period kp is inversely proportional to it and given as kp * period [s].
+ * The integral time is in ms.
+ */
+#include "cruise_gains.h"
+#define CRUISE_FF_LOOKAHEAD 0         /* [ms], see cruise_ctl_set_feedforward() */
+
+typedef struct {
+  enum active gas_pedal;
+  enum active top_gear;
+  enum active cruise_control;
+  enum active engine;
+} cruise_inputs;
+
+typedef struct {
+  int     cruising;
+  INT32S  target;    /* cruise velocity Q15.16 [m/s], 0 when not cruising */
+  INT8U   throttle;  /* last output */
+  INT32S  kp_period;    /* Q15.16 [s] */
+  INT16U  ti;           /* [ms] */
+  INT32S  kd;           /* Q15.16 [s] */
+  INT32S  feedforward;  /* part of the last output Q15.16 */
+  const track *ff_track; /* NULL: no feedforward */
+  INT16U  ff_lookahead; /* [ms] */
+  pid_ctl pid;
+} cruise_ctl;
+
+void  cruise_ctl_init(cruise_ctl *c, INT16U period_ms);
+void  cruise_ctl_set_period(cruise_ctl *c, INT16U period_ms);
+/* Replaces the tuning of cruise_gains.h, see there for the units */
+void  cruise_ctl_set_gains(cruise_ctl *c, INT32S kp_period, INT16U ti_ms, INT32S kd);
+/* 't' NULL turns the feedforward off */
+void  cruise_ctl_set_feedforward(cruise_ctl *c, const track *t, INT16U lookahead_ms);
+/* Moves the target while cruising, e.g. to keep a gap; ignored otherwise */
+void  cruise_ctl_set_target(cruise_ctl *c, INT32S target);
+INT8U cruise_ctl_step(cruise_ctl *c, const cruise_inputs *in, INT32S velocity, INT32U position);
+
+#endif /* CRUISE_CONTROL_H */
@@ -0,0 +1,92 @@
+/* Gains of the cruise controller
+ *
+ * Generated by host/autotune -f 0 -o ../src/cruise_gains.h, do not edit.
+ *
+ * CRUISE_GAIN_SETS lists the Pareto-best candidates over the standard
+ * scenarios of autotune.c, by settling time; CRUISE_KP_PERIOD, CRUISE_TI
+ * and CRUISE_KD are the balanced one of them.
+ *
+ * X(kp * period [s], ti [ms], kd [s], settling [s], overshoot [m/s], effort, rms error [m/s])
+ */
+#ifndef CRUISE_GAINS_H
+#define CRUISE_GAINS_H
+
+#include "cruise_pid.h"
+
+#define CRUISE_GAIN_SETS(X) \
+  X(0.700,  250, 0.050,  0.30, 0.294,   337, 0.1590) \
+  X(0.700,  250, 0.000,  0.33, 0.294,   323, 0.1588) \
+  X(0.600,  250, 0.000,  0.55, 0.303,   295, 0.1616) \
+  X(0.600,  250, 0.050,  0.55, 0.294,   303, 0.1593) \
+  X(0.600,  250, 0.100,  0.57, 0.288,   320, 0.1598) \
+  X(1.000,  500, 0.000,  0.65, 0.284,   371, 0.1641) \
+  X(0.500,  250, 0.000,  0.70, 0.294,   250, 0.1661) \
+  X(0.900,  500, 0.000,  0.78, 0.273,   334, 0.1620) \
+  X(0.800,  500, 0.000,  0.83, 0.273,   288, 0.1629) \
+  X(0.800,  500, 0.100,  0.83, 0.241,   333, 0.1670) \
+  X(0.400,  250, 0.000,  0.85, 0.292,   232, 0.1803) \
+  X(0.800,  500, 0.050,  0.85, 0.264,   309, 0.1641) \
+  X(0.700,  500, 0.000,  0.95, 0.273,   253, 0.1678) \
+  X(1.000,  750, 0.000,  0.98, 0.241,   337, 0.1684) \
+  X(0.700,  500, 0.050,  1.00, 0.264,   266, 0.1681) \
+  X(0.600,  500, 0.000,  1.05, 0.252,   230, 0.1772) \
+  X(0.300,  250, 0.000,  1.12, 0.366,   220, 0.2026) \
+  X(0.600,  500, 0.100,  1.12, 0.234,   243, 0.1765) \
+  X(0.300,  250, 0.150,  1.15, 0.336,   227, 0.1962) \
+  X(0.600,  500, 0.150,  1.22, 0.234,   254, 0.1757) \
+  X(0.800,  750, 0.000,  1.32, 0.235,   241, 0.1729) \
+  X(0.500,  500, 0.050,  1.35, 0.233,   224, 0.1931) \
+  X(0.200,  250, 0.000,  1.50, 0.399,   217, 0.2503) \
+  X(0.400,  500, 0.000,  1.50, 0.233,   224, 0.2201) \
+  X(0.400,  500, 0.100,  1.65, 0.233,   223, 0.2183) \
+  X(0.300,  500, 0.050,  1.95, 0.233,   221, 0.2622) \
+  X(0.400,  750, 0.050,  2.27, 0.233,   223, 0.2565) \
+  X(0.400,  750, 0.100,  2.35, 0.233,   223, 0.2541) \
+  X(0.100,  250, 0.000,  2.42, 0.466,   210, 0.3751) \
+  X(0.100,  250, 0.050,  2.50, 0.427,   217, 0.3719) \
+  X(0.200,  500, 0.000,  2.55, 0.233,   218, 0.3386) \
+  X(0.100,  500, 0.050,  4.27, 0.233,   216, 0.5159) \
+  X(0.100,  500, 0.000,  4.42, 0.233,   216, 0.5128) \
+  X(0.100,  750, 0.000,  6.72, 0.233,   212, 0.6264) \
+  X(0.200, 1500, 0.000,  8.03, 0.233,   212, 0.5599) \
+  X(0.100, 1000, 0.000,  9.22, 0.233,   207, 0.7178) \
+  X(0.100, 1250, 0.150, 11.82, 0.233,   207, 0.7969) \
+  X(0.100, 1250, 0.100, 11.83, 0.233,   206, 0.7981) \
+  X(0.100, 1250, 0.000, 11.85, 0.233,   203, 0.7999) \
+  X(0.100, 1500, 0.000, 14.35, 0.233,   198, 0.8731) \
+  X(0.100, 1750, 0.050, 16.97, 0.233,   197, 0.9395) \
+  X(0.100, 1750, 0.000, 17.02, 0.233,   193, 0.9424) \
+  X(0.100, 2000, 0.000, 19.55, 0.233,   190, 1.0053) \
+  X(0.100, 2250, 0.200, 21.68, 0.231,   200, 1.0688) \
+  X(0.100, 2250, 0.150, 21.70, 0.231,   195, 1.0656) \
+  X(0.100, 2250, 0.100, 21.82, 0.182,   194, 1.0635) \
+  X(0.100, 2250, 0.050, 22.05, 0.182,   189, 1.0631) \
+  X(0.100, 2250, 0.000, 22.30, 0.182,   186, 1.0638) \
+  X(0.100, 2500, 0.200, 24.17, 0.182,   197, 1.1242) \
+  X(0.100, 2500, 0.050, 24.43, 0.182,   185, 1.1207) \
+  X(0.100, 2500, 0.000, 24.75, 0.182,   184, 1.1229) \
+  X(0.100, 2750, 0.200, 26.62, 0.182,   197, 1.1794) \
+  X(0.100, 2750, 0.050, 26.77, 0.182,   182, 1.1756) \
+  X(0.100, 2750, 0.000, 27.40, 0.182,   180, 1.1744) \
+  X(0.100, 3000, 0.150, 29.12, 0.182,   190, 1.2304) \
+  X(0.100, 3000, 0.200, 29.15, 0.182,   194, 1.2323) \
+  X(0.100, 3000, 0.000, 29.93, 0.182,   175, 1.2270) \
+  X(0.100, 3250, 0.150, 31.47, 0.182,   187, 1.2807) \
+  X(0.100, 3250, 0.200, 31.52, 0.153,   193, 1.2839) \
+  X(0.100, 3250, 0.000, 32.47, 0.182,   173, 1.2754) \
+  X(0.100, 3500, 0.200, 33.95, 0.153,   189, 1.3304) \
+  X(0.100, 3500, 0.150, 34.05, 0.153,   186, 1.3286) \
+  X(0.100, 3500, 0.000, 35.05, 0.182,   170, 1.3224) \
+  X(0.100, 3750, 0.150, 36.52, 0.153,   182, 1.3746) \
+  X(0.100, 3750, 0.100, 36.75, 0.182,   177, 1.3733) \
+  X(0.100, 3750, 0.000, 37.40, 0.182,   165, 1.3696) \
+  X(0.100, 4000, 0.150, 39.02, 0.153,   181, 1.4211) \
+  X(0.100, 4000, 0.100, 39.18, 0.182,   176, 1.4181) \
+  X(0.100, 4000, 0.050, 39.73, 0.182,   167, 1.4152) \
+  X(0.100, 4000, 0.000, 40.07, 0.182,   163, 1.4142)
+
+#define CRUISE_KP_PERIOD PID_FIX(0.300) /* kp * period [s] */
+#define CRUISE_TI        500          /* integral time [ms] */
+#define CRUISE_KD        PID_FIX(0.050) /* [s] */
+
+#endif /* CRUISE_GAINS_H */
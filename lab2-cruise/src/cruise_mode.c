@@ -0,0 +1,126 @@
+/* Graceful degradation under overload, see cruise_mode.h */
+#include <stdio.h>
+#include <string.h>
+#include "cruise_mode.h"
+#include "cruise_clock.h"
+
+#define MODE_MARGIN_US ((INT32U)MODE_MARGIN * HYPERPERIOD) /* per mille of ms in us */
+
+typedef struct {
+  const char *name;
+  INT8U divider;   /* releases per run when degraded, 0: shed */
+  INT32U budget;   /* [us] */
+} mode_task;
+
+#define MODE_TASK(name, period, deadline, budget, crit, stack) \
+  {#name, (crit) == TASK_CRIT_LOW ? MODE_DIVIDER_LOW : 1, budget},
+static const mode_task tasks[TASK_COUNT] = { CRUISE_TASKS(MODE_TASK) };
+#undef MODE_TASK
+
+static enum cruise_mode mode;
+static INT32U since;        /* [us], start of the current mode */
+static INT32U changes;
+static INT32U degraded_ms;  /* of the finished degraded periods */
+static INT32U clean;        /* hyperperiods without overload while degraded */
+static INT32U slack_sum, shed_sum; /* [us] over the clean hyperperiods */
+static INT32U shed_us;      /* since the last mode_update() */
+static INT8U phase[TASK_COUNT];
+static INT32U shed[TASK_COUNT];
+
+void mode_init(void)
+{
+  mode = MODE_NORMAL;
+  since = cruise_clock_us();
+  changes = degraded_ms = clean = slack_sum = shed_sum = shed_us = 0;
+  memset(phase, 0, sizeof(phase));
+  memset(shed, 0, sizeof(shed));
+}
+
+static void change(enum cruise_mode to, INT32U now)
+{
+  INT32U ms = (now - since) / 1000;
+
+  if (to == MODE_DEGRADED) {
+    printf("mode: degraded at %lu ms, shedding low criticality tasks\n",
+           (unsigned long)(now / 1000));
+  } else {
+    degraded_ms += ms;
+    printf("mode: normal at %lu ms, after %lu ms degraded\n", (unsigned long)(now / 1000),
+           (unsigned long)ms);
+  }
+  mode = to;
+  since = now;
+  changes++;
+  clean = slack_sum = shed_sum = 0;
+}
+
+void mode_update(int overloaded, INT32U slack_us)
+{
+  INT32U now = cruise_clock_us(), shed_now;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  shed_now = shed_us;
+  shed_us = 0;
+  OS_EXIT_CRITICAL();
+
+  if (mode == MODE_NORMAL) {
+    if (overloaded)
+      change(MODE_DEGRADED, now);
+    return;
+  }
+  if (overloaded) {
+    clean = slack_sum = shed_sum = 0;
+    return;
+  }
+  /* without a measurement assume just enough slack */
+  if (slack_us == MODE_SLACK_UNKNOWN)
+    slack_us = shed_now + MODE_MARGIN_US;
+  clean++;
+  slack_sum += slack_us;
+  shed_sum += shed_now;
+  if (clean >= MODE_RECOVER && slack_sum >= shed_sum + clean * MODE_MARGIN_US)
+    change(MODE_NORMAL, now);
+}
+
+enum cruise_mode mode_get(void)
+{
+  return mode;
+}
+
+int mode_runs(INT8U task, INT32U demand_us)
+{
+  const mode_task *t = &tasks[task];
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  if (mode == MODE_NORMAL || t->divider == 1)
+    return 1;
+  if (t->divider && ++phase[task] >= t->divider) {
+    phase[task] = 0;
+    return 1;
+  }
+  OS_ENTER_CRITICAL();
+  shed[task]++;
+  shed_us += demand_us ? demand_us : t->budget;
+  OS_EXIT_CRITICAL();
+  return 0;
+}
+
+void mode_print(void)
+{
+  INT32U ms = degraded_ms;
+  int i;
+
+  if (mode == MODE_DEGRADED)
+    ms += (cruise_clock_us() - since) / 1000;
+  printf("mode: %s, %lu changes, %lu ms degraded, shed:", mode == MODE_NORMAL ? "normal" : "degraded",
+         (unsigned long)changes, (unsigned long)ms);
+  for (i = 0; i < TASK_COUNT; i++)
+    if (tasks[i].divider != 1)
+      printf(" %s %lu", tasks[i].name, (unsigned long)shed[i]);
+  printf("\n");
+}
@@ -0,0 +1,49 @@
+/* Graceful degradation under overload
+ *
+ * Description:
+ *
+ *   The application runs in one of two modes:
+ *
+ *     MODE_NORMAL    every task runs every release,
+ *     MODE_DEGRADED  the tasks of TASK_CRIT_LOW only run one release in
+ *                    MODE_DIVIDER_LOW (0: none), the others keep their
+ *                    timing.
+ *
+ *   WatchdogTask calls mode_update() once per hyperperiod. An overloaded
+ *   hyperperiod (no watchdog reset or a deadline miss) switches to
+ *   MODE_DEGRADED. The system returns to MODE_NORMAL after MODE_RECOVER
+ *   hyperperiods without overload in which the idle time would also have
+ *   covered the shed work plus MODE_MARGIN, so it does not fall straight
+ *   back into overload.
+ *
+ *   A task that may be shed asks mode_runs() at every release, with the
+ *   execution time the release would need, and skips its work but not its
+ *   handshakes (finish flags, semaphores) when it returns 0.
+ *
+ *   Every mode change is printed with its time; mode_print() sums up the
+ *   time spent degraded and the releases shed per task.
+ */
+#ifndef CRUISE_MODE_H
+#define CRUISE_MODE_H
+
+#include "cruise_types.h"
+#include "cruise_tasks.h"
+
+#define MODE_DIVIDER_LOW 4   /* releases per run of a LOW task when degraded */
+#define MODE_RECOVER     3   /* hyperperiods */
+#define MODE_MARGIN      100 /* per mille of the hyperperiod */
+
+/* mode_update() slack when the idle time is not measured (no OS_APP_HOOKS_EN) */
+#define MODE_SLACK_UNKNOWN 0xffffffffUL
+
+enum cruise_mode {MODE_NORMAL, MODE_DEGRADED};
+
+void mode_init(void);
+/* Once per hyperperiod; 'slack_us' is the idle time of the last one */
+void mode_update(int overloaded, INT32U slack_us);
+enum cruise_mode mode_get(void);
+/* 1 if the current release of 'task' should do its work; 'demand_us' 0: its budget */
+int mode_runs(INT8U task, INT32U demand_us);
+void mode_print(void);
+
+#endif /* CRUISE_MODE_H */
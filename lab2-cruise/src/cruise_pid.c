@@ -0,0 +1,88 @@
+/* Fixed-point PID controller, see cruise_pid.h */
+#include "cruise_pid.h"
+
+static INT32S mul_q16(INT32S a, INT32S b)
+{
+  return (INT32S)(((INT64S)a * b + (1 << (PID_FRAC_BITS - 1))) >> PID_FRAC_BITS);
+}
+
+static INT32S clamp(INT32S x, INT32S lo, INT32S hi)
+{
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+void pid_init(pid_ctl *c, INT32S kp, INT32S ki, INT32S kd, INT16U period_ms,
+              INT32S out_min, INT32S out_max)
+{
+  c->kp = kp;
+  c->ki = ki;
+  c->kd = kd;
+  c->out_min = out_min;
+  c->out_max = out_max;
+  pid_set_period(c, period_ms);
+  pid_reset(c, 0, out_min);
+}
+
+void pid_set_gains(pid_ctl *c, INT32S kp, INT32S ki, INT32S kd)
+{
+  c->kp = kp;
+  c->ki = ki;
+  c->kd = kd;
+  pid_set_period(c, c->period);
+}
+
+/*
+ * New output limits, e.g. when a feedforward term takes part of the range.
+ * The integrator follows at the next update.
+ */
+void pid_set_limits(pid_ctl *c, INT32S out_min, INT32S out_max)
+{
+  c->out_min = out_min;
+  c->out_max = out_max;
+}
+
+/*
+ * Discretises ki and kd for a period of 'period_ms'. Can be called at any
+ * time, the state of the controller is kept.
+ */
+void pid_set_period(pid_ctl *c, INT16U period_ms)
+{
+  c->period = period_ms;
+  c->ki_dt = (INT32S)(((INT64S)c->ki * period_ms + 500) / 1000);
+  c->kd_dt = (INT32S)(((INT64S)c->kd * 1000 + period_ms / 2) / period_ms);
+}
+
+/*
+ * Prepares the controller to take over from an output of 'output' at a
+ * measurement of 'measure' without a step in the output.
+ */
+void pid_reset(pid_ctl *c, INT32S measure, INT32S output)
+{
+  c->integral = clamp(output, c->out_min, c->out_max);
+  c->prev_measure = measure;
+}
+
+INT32S pid_update(pid_ctl *c, INT32S setpoint, INT32S measure)
+{
+  INT32S error = setpoint - measure;
+  INT32S p, d, out;
+
+  p = mul_q16(c->kp, error);
+  d = - mul_q16(c->kd_dt, measure - c->prev_measure);
+  c->prev_measure = measure;
+
+  c->integral += mul_q16(c->ki_dt, error);
+  out = p + c->integral + d;
+
+  // anti-windup: keep the integrator where the output just saturates
+  if (out > c->out_max) {
+    if (c->integral > c->out_max - p - d)
+      c->integral = clamp(c->out_max - p - d, c->out_min, c->out_max);
+    out = c->out_max;
+  } else if (out < c->out_min) {
+    if (c->integral < c->out_min - p - d)
+      c->integral = clamp(c->out_min - p - d, c->out_min, c->out_max);
+    out = c->out_min;
+  }
+  return out;
+}
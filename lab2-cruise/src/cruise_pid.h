@@ -0,0 +1,44 @@
+/* Fixed-point PID controller
+ *
+ * Description:
+ *
+ *   Discrete PID controller in Q15.16 arithmetic. The gains are given in
+ *   continuous time (kp [1], ki [1/s], kd [s]) and discretised for the
+ *   period of the calling task by pid_set_period(), so the same tuning can be
+ *   used at any control rate. The derivative acts on the measurement only,
+ *   so a change of the setpoint does not cause a kick.
+ *
+ *   Anti-windup: whenever the output saturates, the integrator is clamped so
+ *   that the unsaturated output does not exceed the limit.
+ *
+ *   Bumpless transfer: pid_reset() loads the integrator with the output that
+ *   was applied before the controller took over, so the first output of the
+ *   controller continues from it.
+ */
+#ifndef CRUISE_PID_H
+#define CRUISE_PID_H
+
+#include "cruise_types.h"
+
+#define PID_FRAC_BITS 16
+#define PID_ONE       (1L << PID_FRAC_BITS)
+#define PID_FIX(x)    ((INT32S)((x) * PID_ONE)) /* for constant gains */
+
+typedef struct {
+  INT32S kp, ki, kd;        /* continuous gains Q15.16 */
+  INT32S ki_dt, kd_dt;      /* ki * dt and kd / dt for the current period, Q15.16 */
+  INT16U period;            /* [ms] */
+  INT32S out_min, out_max;  /* output limits Q15.16 */
+  INT32S integral;          /* integrator Q15.16, in units of the output */
+  INT32S prev_measure;      /* measurement of the previous update */
+} pid_ctl;
+
+void   pid_init(pid_ctl *c, INT32S kp, INT32S ki, INT32S kd, INT16U period_ms,
+                INT32S out_min, INT32S out_max);
+void   pid_set_gains(pid_ctl *c, INT32S kp, INT32S ki, INT32S kd);
+void   pid_set_period(pid_ctl *c, INT16U period_ms);
+void   pid_set_limits(pid_ctl *c, INT32S out_min, INT32S out_max);
+void   pid_reset(pid_ctl *c, INT32S measure, INT32S output);
+INT32S pid_update(pid_ctl *c, INT32S setpoint, INT32S measure);
+
+#endif /* CRUISE_PID_H */
@@ -25,11 +25,56 @@
 #include "altera_avalon_performance_counter.h"
 #include "sys/alt_irq.h"
 #include "sys/alt_alarm.h"
+#ifdef HIGH_RES_TIMER_BASE
+#include "altera_avalon_timer_regs.h"
+#endif
+#include "cruise_clock.h"
+#include "cruise_tasks.h"
+#include "cruise_boot.h"
+#include "cyclic_exec.h"
+#include "hr_timer.h"
+#include "task_monitor.h"
+#include "cpu_account.h"
+#include "load_gen.h"
+#include "headroom.h"
+#include "cruise_mode.h"
+#include "display.h"
+#include "e2e_trace.h"
+#include "telemetry.h"
+#include "input_replay.h"
+#include "replay_script.h"
+#include "topic_bus.h"
+#include "track.h"
+#include "vehicle_model.h"
+#include "cruise_control.h"
+#include "control_rate.h"
 
 #define DEBUG 0
-
-#define HW_TIMER_PERIOD 100 /* 100ms */
-#define CALIBRATION    2300 /* calibaration factor for addload  for loop */
+#define VEHICLE_PROFILE 0 /* print the cycles spent in vm_step() */
+#define CYCLIC_EXECUTIVE 0 /* run the tasks from a cyclic schedule instead of one OS_TMR each */
+#define MONITOR_SUMMARY 0  /* print the task monitor every n hyperperiods, 0: only on overload */
+#define CPU_EXPORT 0       /* print the CPU load per task every n hyperperiods, 0: never */
+#define TRACE_EXPORT 0     /* print the end-to-end latencies every n hyperperiods, 0: never */
+#define TELEMETRY_FLUSH 0  /* stream up to n telemetry records per hyperperiod to stdout, 0: RAM only */
+#define TELEMETRY_DELTA 1  /* delta-encode the telemetry stream, see telemetry.h */
+#define INPUT_REPLAY 0     /* read keys and switches from replay_script.h, see input_replay.h */
+#define BOOT_STAT_INIT 0  /* calibrate OSCPUUsage with OSStatInit(), adds ~100 ms to the boot */
+#define DEGRADATION 1     /* shed low criticality tasks under overload, see cruise_mode.h */
+#define FEEDFORWARD 1     /* add the throttle for the slope ahead while cruising, see cruise_control.h */
+#define ADAPTIVE_RATE 0   /* adapt the period of ControlTask and VehicleTask, see control_rate.h */
+#define HEADROOM_TEST 0   /* search the largest sustainable extra load n times, 0: off */
+
+/* Headroom search (HEADROOM_TEST), see headroom.h */
+#define HEADROOM_SETTLE     2 /* hyperperiods ignored after each load change */
+#define HEADROOM_PROBE      5 /* hyperperiods without a miss to accept a load */
+#define HEADROOM_RESOLUTION 5 /* per mille of EXTRALOAD_PERIOD */
+
+/* Load profile of ExtraloadTask, see load_gen.h */
+#define EXTRALOAD_MODE      LOAD_SWITCHES
+#define EXTRALOAD_BASE      0   /* per mille of EXTRALOAD_PERIOD */
+#define EXTRALOAD_AMPLITUDE 500 /* per mille of EXTRALOAD_PERIOD */
+#define EXTRALOAD_LENGTH    100 /* releases */
+#define EXTRALOAD_SEED      1
 
 /* Button Patterns */
 
@@ -62,43 +107,23 @@
 #define LED_GREEN_4 0x00000010 // Brake Pedal
 #define LED_GREEN_6 0x00000040 // Gas Pedal
 
+/* LEDs set by each source, see display.h */
+#define LEDS_BUTTON   (LED_GREEN_2 | LED_GREEN_4 | LED_GREEN_6)
+#define LEDS_CONTROL  LED_GREEN_0
+#define LEDS_SWITCH   (LED_RED_0 | LED_RED_1)
+#define LEDS_POSITION (LED_RED_12 | LED_RED_13 | LED_RED_14 | LED_RED_15 | LED_RED_16 | LED_RED_17)
+
 /*
  * Definition of Tasks
  */
 
-#define TASK_STACKSIZE 2048
-
 OS_STK StartTask_Stack[TASK_STACKSIZE]; 
-OS_STK ControlTask_Stack[TASK_STACKSIZE]; 
-OS_STK VehicleTask_Stack[TASK_STACKSIZE];
-OS_STK ButtonIO_Stack[TASK_STACKSIZE];
-OS_STK SwitchIO_Stack[TASK_STACKSIZE];
-OS_STK DisplayTask_Stack[TASK_STACKSIZE];
-OS_STK WatchdogTask_Stack[TASK_STACKSIZE];
-OS_STK OverloadDetection_Stack[TASK_STACKSIZE];
-OS_STK ExtraloadTask_Stack[TASK_STACKSIZE];
-
-// Task Priorities
-#define WATCHDOGTASK_PRIO  4
-#define STARTTASK_PRIO     5
-#define BUTTONIO_PRIO      8
-#define SWITCHIO_PRIO      9
-#define DISPLAYTASK_PRIO   10
-#define VEHICLETASK_PRIO   11
-#define CONTROLTASK_PRIO   12
-#define EXTRALOADTASK_PRIO 14
-#define OVERLOADDETECTION_PRIO   13
-
-// Task Periods
-#define HYPERPERIOD       300
-#define CONTROL_PERIOD    300
-#define VEHICLE_PERIOD    300
-#define BUTTONIO_PERIOD   100
-#define SWITCHIO_PERIOD   300
-#define DISPLAY_PERIOD    300
-#define WATCHDOG_PERIOD   HYPERPERIOD
-#define OVERLOAD_PERIOD   HYPERPERIOD
-#define EXTRALOAD_PERIOD  HYPERPERIOD
+
+/* One stack per task of CRUISE_TASKS, see cruise_tasks.h */
+#define TASK_STACK(name, period, deadline, budget, crit, stack) OS_STK name##_Stack[stack];
+CRUISE_TASKS(TASK_STACK)
+#undef TASK_STACK
+OS_STK CyclicExecutive_Stack[TASK_STACKSIZE];
 
 /*
  * Definition of Kernel Objects 
@@ -107,280 +132,227 @@ OS_STK ExtraloadTask_Stack[TASK_STACKSIZE];
 // Mailboxes
 OS_EVENT *Mbox_Throttle;
 OS_EVENT *Mbox_Velocity;
-OS_EVENT *Mbox_Brake;
-OS_EVENT *Mbox_Engine_Control;
-OS_EVENT *Mbox_Engine_Vehicle;
-OS_EVENT *Mbox_TopGear;
-OS_EVENT *Mbox_GasPedal;
-OS_EVENT *Mbox_Cruise;
 OS_EVENT *Mbox_ButtonOut;
 OS_EVENT *Mbox_SwitchOut;
-OS_EVENT *Mbox_PositionOut;
 OS_EVENT *Mbox_ControlOut;
 OS_EVENT *Mbox_WatchdogReset;
 
-// Semaphores
-OS_EVENT *VehicleSem   = NULL;
-OS_EVENT *ControlSem   = NULL;
-OS_EVENT *ButtonSem    = NULL;
-OS_EVENT *SwitchSem    = NULL;
-OS_EVENT *DisplaySem   = NULL;
-OS_EVENT *WatchdogSem  = NULL;
-OS_EVENT *OverloadSem  = NULL;
-OS_EVENT *ExtraloadSem = NULL;
+// Semaphores, one per task of CRUISE_TASKS, posted by its SW timer
+OS_EVENT *task_sem[TASK_COUNT];
 OS_EVENT *ExtraloadFinishSem = NULL;
 
-// SW-Timer
-OS_TMR *VehicleTmr   = NULL; // Timer used by vehicle task
-OS_TMR *ControlTmr   = NULL; // Timer used by control task
-OS_TMR *ButtonTmr    = NULL;
-OS_TMR *SwitchTmr    = NULL; // Timer used by SwitchIO
-OS_TMR *DisplayTmr   = NULL;
-OS_TMR *WatchdogTmr  = NULL;
-OS_TMR *OverloadTmr  = NULL;
-OS_TMR *ExtraloadTmr = NULL;
+#define TASK_SEM(name) task_sem[name##_id]
 
-/*
- * Types
- */
-enum active {on = 2, off = 1};
+// SW-Timer, one per task of CRUISE_TASKS, see hr_timer.h
+hrt_timer task_tmr[TASK_COUNT];
 
+// Minor frames of the cyclic executive (CYCLIC_EXECUTIVE)
+OS_EVENT *FrameSem = NULL;
+hrt_timer frame_tmr;
 
 /*
  * Global variables
  */
 int delay; // Delay of HW-timer 
 int gflag_finish[5];
+/* task of every gflag_finish entry */
+static const INT8U gflag_task[5] = {ButtonIO_id, SwitchIO_id, VehicleTask_id, ControlTask_id,
+                                    DisplayTask_id};
+/* released since the last check of OverloadDetection */
+static volatile INT8U task_released[TASK_COUNT];
 
 /*
  * Helper functions
  */
 
-int buttons_pressed(void)
+/*
+ * 'ms' is the logical time of the release of the reading task, it selects
+ * the state of the replay script with INPUT_REPLAY. The keys are active low.
+ */
+int buttons_pressed(INT32U ms)
 {
+  if (INPUT_REPLAY)
+    return ~replay_keys(ms);
   return IORD_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE);
 }
 
-int switches_pressed(void)
+int switches_pressed(INT32U ms)
 {
+  if (INPUT_REPLAY)
+    return replay_switches(ms);
   return IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE);
 }
 
-static void ButtonIOCallback(void *ptmr, void *callback_arg)
+/*
+ * Every task of CRUISE_TASKS is split in name_init(), which runs once
+ * before the first release, and name_step(), the work of one release.
+ * periodic_task() (or the cyclic executive) calls them, so the tasks keep
+ * their state in static variables and never block.
+ */
+
+// The interrupt service routine
+static enum active cruise_control;
+static trace_msg button_out; /* posted to DisplayTask */
+static trace_tag button_tag;
+static INT32U button_time; /* logical time of the release [ms] */
+
+static void ButtonIO_init(void)
 {
-  OSSemPost(ButtonSem);
+  cruise_control = off;
 }
 
-// The interrupt service routine
-static void ButtonIO(void* context, alt_u32 id)
+static void ButtonIO_step(void)
 { 
   int btn_reg = 0;
-  int out = 0;
-  enum active brake_pedal, gas_pedal, cruise_control;
-  cruise_control = off;
+  enum active brake_pedal, gas_pedal;
   INT8U err;
-  printf("ButtonIO task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    out = 0;
-    brake_pedal = gas_pedal = off;
-    btn_reg = buttons_pressed();
-    btn_reg = ~btn_reg;
-    btn_reg = btn_reg & 0xf;
-
-    switch (btn_reg) {
-      case CRUISE_CONTROL_FLAG:                         // cruise_control button pressed
-        cruise_control = (cruise_control == on)?off:on; // toggle cruise_control
-        break;
-      case BRAKE_PEDAL_FLAG:
-        brake_pedal = on;
-        break;
-      case GAS_PEDAL_FLAG:
-        gas_pedal = on;
-        break;
-      default:
-        break;
-    }
-  
-    if (cruise_control == on) {
-      out += LED_GREEN_2;
-    }
-    if (brake_pedal == on) {
-      out += LED_GREEN_4;
-    }
-    if (gas_pedal == on) {
-      out += LED_GREEN_6;
-    }
 
-    err = OSMboxPost(Mbox_Brake, (void *)&brake_pedal);
-    if (err != OS_ERR_NONE && DEBUG) {
-      printf("OSMboxPost error! line %d\n", __LINE__);
-    }
-    err = OSMboxPost(Mbox_Cruise, (void *)&cruise_control);
-    if (err != OS_ERR_NONE && DEBUG) {
-      printf("OSMboxPost error! line %d\n", __LINE__);
-    }
-    err = OSMboxPost(Mbox_GasPedal, (void *)&gas_pedal);
-    if (err != OS_ERR_NONE && DEBUG) {
-      printf("OSMboxPost error! line %d\n", __LINE__);
-    }
+  button_out.value = 0;
+  brake_pedal = gas_pedal = off;
+  btn_reg = buttons_pressed(button_time);
+  trace_sample(&button_tag);
+  if (INPUT_REPLAY && button_time <= replay_length()
+      && button_time + BUTTONIO_PERIOD > replay_length())
+    printf("replay: end of script at %lu ms\n", (unsigned long)replay_length());
+  button_time += BUTTONIO_PERIOD;
+  btn_reg = ~btn_reg;
+  btn_reg = btn_reg & 0xf;
+
+  switch (btn_reg) {
+    case CRUISE_CONTROL_FLAG:                         // cruise_control button pressed
+      cruise_control = (cruise_control == on)?off:on; // toggle cruise_control
+      break;
+    case BRAKE_PEDAL_FLAG:
+      brake_pedal = on;
+      break;
+    case GAS_PEDAL_FLAG:
+      gas_pedal = on;
+      break;
+    default:
+      break;
+  }
 
-    err = OSMboxPost(Mbox_ButtonOut, (void *)&out);
-    if (err != OS_ERR_NONE && DEBUG) {
-      printf("OSMboxPost error! line %d\n", __LINE__);
-    }
-    
-    gflag_finish[0] = 1;
-    OSSemPend(ButtonSem, 0, &err);
+  if (cruise_control == on) {
+    button_out.value += LED_GREEN_2;
   }
+  if (brake_pedal == on) {
+    button_out.value += LED_GREEN_4;
+  }
+  if (gas_pedal == on) {
+    button_out.value += LED_GREEN_6;
+  }
+
+  topic_publish_traced(TOPIC_BRAKE, &brake_pedal, &button_tag);
+  topic_publish_traced(TOPIC_CRUISE, &cruise_control, &button_tag);
+  topic_publish_traced(TOPIC_GAS_PEDAL, &gas_pedal, &button_tag);
+
+  button_out.tag = button_tag;
+  err = OSMboxPost(Mbox_ButtonOut, (void *)&button_out);
+  if (err != OS_ERR_NONE && DEBUG) {
+    printf("OSMboxPost error! line %d\n", __LINE__);
+  }
+
+  gflag_finish[0] = 1;
 }
 
-static void SwitchIOCallback(void *ptmr, void *callback_arg)
+// The interrupt service for switches
+static trace_msg switch_out; /* posted to DisplayTask */
+static trace_tag switch_tag;
+static INT32U switch_time; /* logical time of the release [ms] */
+
+static void SwitchIO_init(void)
 {
-  OSSemPost(SwitchSem);
 }
 
-// The interrupt service for switches
-static void SwitchIO(void)
+static void SwitchIO_step(void)
 {
   int btn_reg = 0;
-  int out = 0;
-  enum active engine_control, engine_vehicle, top_gear;
-  engine_control = engine_vehicle = top_gear = off;
-  INT8U err;
-  printf("SwitchIO task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    engine_control = engine_vehicle = top_gear = off;
-    out = 0;
-    btn_reg = switches_pressed();
-    btn_reg = btn_reg & 0xf;
+  enum active engine, top_gear;
 
-    engine_control = engine_vehicle = (btn_reg & ENGINE_FLAG)?on:off;
-    top_gear = (btn_reg & TOP_GEAR_FLAG)?on:off;
+  switch_out.value = 0;
+  btn_reg = switches_pressed(switch_time);
+  switch_time += SWITCHIO_PERIOD;
+  trace_sample(&switch_tag);
+  btn_reg = btn_reg & 0xf;
 
-    if (engine_control == on) {
-      out += LED_RED_0;
-    }
-    if (top_gear == on) {
-      out += LED_RED_1;
-    }
+  engine = (btn_reg & ENGINE_FLAG)?on:off;
+  top_gear = (btn_reg & TOP_GEAR_FLAG)?on:off;
 
-    err = OSMboxPost(Mbox_Engine_Control, (void *)&engine_control);
-    err = OSMboxPost(Mbox_Engine_Vehicle, (void *)&engine_vehicle);
-    err = OSMboxPost(Mbox_TopGear, (void *)&top_gear);
+  if (engine == on) {
+    switch_out.value += LED_RED_0;
+  }
+  if (top_gear == on) {
+    switch_out.value += LED_RED_1;
+  }
 
-    err = OSMboxPost(Mbox_SwitchOut, (void *)&out);
+  /* one publish reaches both ControlTask and VehicleTask */
+  topic_publish_traced(TOPIC_ENGINE, &engine, &switch_tag);
+  topic_publish_traced(TOPIC_TOP_GEAR, &top_gear, &switch_tag);
 
-    gflag_finish[1] = 1;
-    OSSemPend(SwitchSem, 0, &err);
-  }
+  switch_out.tag = switch_tag;
+  OSMboxPost(Mbox_SwitchOut, (void *)&switch_out);
+
+  gflag_finish[1] = 1;
 }
 
 /*
- * ISR for HW Timer
+ * ISR for HW Timer, ticks the SW timers every HRT_TICK_US
  */
 alt_u32 alarm_handler(void* context)
 {
-  OSTmrSignal(); /* Signals a 'tick' to the SW timers */
+  cpu_isr_enter();
+  hrt_tick();
+  cpu_isr_exit(CPU_ISR_TIMER);
 
   return delay;
 }
 
-static int b2sLUT[] = {0x40, //0
-  0x79, //1
-  0x24, //2
-  0x30, //3
-  0x19, //4
-  0x12, //5
-  0x02, //6
-  0x78, //7
-  0x00, //8
-  0x18, //9
-  0x3F, //-
-};
-
-/*
- * convert int to seven segment display format
- */
-int int2seven(int inval){
-  return b2sLUT[inval];
-}
-
-/*
- * output current velocity on the seven segement display
- */
-void show_velocity_on_sevenseg(INT8S velocity){
-  int tmp = velocity;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
-  INT8U out_sign = 0;
-
-  if(velocity < 0){
-    out_sign = int2seven(10);
-    tmp *= -1;
-  }else{
-    out_sign = int2seven(0);
-  }
-
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-
-  out = int2seven(0) << 21 |
-    out_sign << 14 |
-    out_high << 7  |
-    out_low;
-  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_LOW28_BASE,out);
+#ifdef HIGH_RES_TIMER_BASE
+/* Interval timer for resolutions below the system tick */
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+static void high_res_timer_isr(void* context)
+#else
+static void high_res_timer_isr(void* context, alt_u32 id)
+#endif
+{
+  cpu_isr_enter();
+  IOWR_ALTERA_AVALON_TIMER_STATUS(HIGH_RES_TIMER_BASE, 0);
+  hrt_tick();
+  cpu_isr_exit(CPU_ISR_TIMER);
 }
 
-/*
- * shows the target velocity on the seven segment display (HEX5, HEX4)
- * when the cruise control is activated (0 otherwise)
- */
-void show_target_velocity(INT16S target_vel)
+static int high_res_timer_start(void)
 {
-  int tmp = (int)target_vel;
-  int out;
-  INT8U out_high = 0;
-  INT8U out_low = 0;
-
-  out_high = int2seven(tmp / 10);
-  out_low = int2seven(tmp - (tmp/10) * 10);
-
-  out = int2seven(0) << 21 |
-    int2seven(0) << 14 |
-    out_high << 7  |
-    out_low;
-  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_HIGH28_BASE,out);
+  alt_u32 period = HIGH_RES_TIMER_FREQ / 1000000 * HRT_TICK_US - 1;
+
+  IOWR_ALTERA_AVALON_TIMER_CONTROL(HIGH_RES_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_STOP_MSK);
+  IOWR_ALTERA_AVALON_TIMER_PERIODL(HIGH_RES_TIMER_BASE, period & 0xffff);
+  IOWR_ALTERA_AVALON_TIMER_PERIODH(HIGH_RES_TIMER_BASE, period >> 16);
+  IOWR_ALTERA_AVALON_TIMER_STATUS(HIGH_RES_TIMER_BASE, 0);
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+  if (alt_ic_isr_register(HIGH_RES_TIMER_IRQ_INTERRUPT_CONTROLLER_ID, HIGH_RES_TIMER_IRQ,
+                          high_res_timer_isr, NULL, NULL) != 0)
+#else
+  if (alt_irq_register(HIGH_RES_TIMER_IRQ, NULL, high_res_timer_isr) != 0)
+#endif
+    return -1;
+  IOWR_ALTERA_AVALON_TIMER_CONTROL(HIGH_RES_TIMER_BASE, ALTERA_AVALON_TIMER_CONTROL_ITO_MSK
+                                   | ALTERA_AVALON_TIMER_CONTROL_CONT_MSK
+                                   | ALTERA_AVALON_TIMER_CONTROL_START_MSK);
+  return 0;
 }
+#endif
+
+/* The track driven by VehicleTask and shown by DisplayTask, see track.h */
+static const track *road = &track_loop;
 
 /*
- * indicates the position of the vehicle on the track with the four leftmost red LEDs
- * LEDR17: [0m, 400m)
- * LEDR16: [400m, 800m)
- * LEDR15: [800m, 1200m)
- * LEDR14: [1200m, 1600m)
- * LEDR13: [1600m, 2000m)
- * LEDR12: [2000m, 2400m]
+ * indicates the position of the vehicle on the track with the LED of the
+ * segment it is on, LEDR17..LEDR12 for the 400m segments of track_loop
  */
-void show_position(INT16U position, int *out)
+void show_position(INT32U position, int *out)
 {
-  if (position < 400) {
-    *out = LED_RED_17;
-  } else if (position >= 400 && position < 800) {
-    *out = LED_RED_16;
-  } else if (position >= 800 && position < 1200) {
-    *out = LED_RED_15;
-  } else if (position >= 1200 && position < 1600) {
-    *out = LED_RED_14;
-  } else if (position >= 1600 && position < 2000) {
-    *out = LED_RED_13;
-  } else {
-    *out = LED_RED_12;
-  }
+  *out = (int)track_led(road, position);
 }
 
 /*
@@ -390,733 +362,832 @@ void show_position(INT16U position, int *out)
  * The car model is equivalent to moving mass with linear resistances acting upon it.
  * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
  * You can prove that easily via basic LTI systems methods.
+ *
+ * The model itself is computed in fixed point by vm_step() (vehicle_model.c), the
+ * task only exchanges its inputs and outputs with the rest of the system.
  */
 
-void VehicleCallback(void *ptmr, void *callback_arg)
-{
-  OSSemPost(VehicleSem);
-}
-
-void VehicleTask(void* pdata)
+static vehicle_state vehicle;
+static INT16U control_period = CONTROL_PERIOD; /* [ms], set by ControlTask (ADAPTIVE_RATE) */
+static INT8U vehicle_throttle;
+static trace_tag vehicle_tag;   /* of the inputs of the last step */
+static INT32S vehicle_velocity; /* Q15.16 [m/s], read by ControlTask */
+static INT16S vehicle_speed;    /* [m/s], published for DisplayTask */
+static INT32U vehicle_position; /* [m] */
+static enum active vehicle_brake, vehicle_engine;
+static topic_sub vehicle_brake_sub, vehicle_engine_sub;
+static topic_sub vehicle_gas_sub, vehicle_top_gear_sub, vehicle_cruise_sub, vehicle_target_sub;
+static enum active vehicle_gas, vehicle_top_gear, vehicle_cruise; /* only recorded */
+static INT16S vehicle_target;
+static INT32U vehicle_steps;
+static INT32U vehicle_time;     /* logical time of the release [ms] */
+
+static void VehicleTask_init(void)
 { 
-  // constants that should not be modified
-  const unsigned int wind_factor = 1;
-  const unsigned int brake_factor = 4;
-  const unsigned int gravity_factor = 2;
-  // variables relevant to the model and its simulation on top of the RTOS
-  int position_out;
-  INT8U err;  
-  void* msg;
-  INT8U* throttle; 
-  INT16S acceleration;  
-  INT16U position = 0; 
-  INT16U previous_position = 0;
-  INT16S velocity = 0; 
-  enum active brake_pedal = off;
-  enum active engine = off;
-
-  printf("Vehicle task created!\n");
-
-  while(1)
-  {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    err = OSMboxPost(Mbox_Velocity, (void *) &velocity);
-
-    OSSemPend(VehicleSem, 0, &err);
-
-    /* Non-blocking read of mailbox: 
-       - message in mailbox: update throttle
-       - no message:         use old throttle
-       */
-    msg = OSMboxPend(Mbox_Throttle, 1, &err); 
-    if (err == OS_ERR_NONE) 
-      throttle = (INT8U*) msg;
-    /* Same for the brake signal that bypass the control law */
-    msg = OSMboxPend(Mbox_Brake, 0, &err); 
-    if (err == OS_ERR_NONE) 
-      brake_pedal = *((enum active *)msg);
-    /* Same for the engine signal that bypass the control law */
-    msg = OSMboxPend(Mbox_Engine_Vehicle, 0, &err); 
-    if (err == OS_ERR_NONE) 
-      engine = *((enum active *)msg);
-
-    // vehichle cannot effort more than 80 units of throttle
-    if (*throttle > 80) *throttle = 80;
-
-    // brakes + wind
-    if (brake_pedal == off)
-    {
-      // wind resistance
-      acceleration = - wind_factor*velocity;
-      // actuate with engines
-      if (engine == on)
-        acceleration += (*throttle);
-
-      // gravity effects
-      if (400 <= position && position < 800)
-        acceleration -= gravity_factor; // traveling uphill
-      else if (800 <= position && position < 1200)
-        acceleration -= 2*gravity_factor; // traveling steep uphill
-      else if (1600 <= position && position < 2000)
-        acceleration += 2*gravity_factor; //traveling downhill
-      else if (2000 <= position)
-        acceleration += gravity_factor; // traveling steep downhill
-    }
-    // if the engine and the brakes are activated at the same time,
-    // we assume that the brake dynamics dominates, so both cases fall
-    // here.
-    else 
-      acceleration = - brake_factor*velocity;
-
-    // printf("Position: %d m\n", position);
-    // printf("Velocity: %d m/s\n", velocity);
-    // printf("Accell: %d m/s2\n", acceleration);
-    // printf("Throttle: %d V\n", *throttle);
-
-    position = position + velocity * VEHICLE_PERIOD / 1000;
-    velocity = velocity  + acceleration * VEHICLE_PERIOD / 1000.0;
-    // reset the position to the beginning of the track
-    if(position > 2400)
-      position = 0;
-
-    show_velocity_on_sevenseg((INT8S) velocity);
-    show_position(position, (void *)&position_out);
-    OSMboxPost(Mbox_PositionOut, &position_out);
-
-    previous_position = position;
-
-    gflag_finish[2] = 1;
-  }
-} 
+  vm_init(&vehicle, VEHICLE_PERIOD);
+  vm_set_track(&vehicle, road);
+  vehicle_throttle = 0;
+  vehicle_velocity = 0;
+  vehicle_brake = vehicle_engine = off;
+  topic_subscribe(&vehicle_brake_sub, TOPIC_BRAKE);
+  topic_subscribe(&vehicle_engine_sub, TOPIC_ENGINE);
+  vehicle_gas = vehicle_top_gear = vehicle_cruise = off;
+  vehicle_target = 0;
+  topic_subscribe(&vehicle_gas_sub, TOPIC_GAS_PEDAL);
+  topic_subscribe(&vehicle_top_gear_sub, TOPIC_TOP_GEAR);
+  topic_subscribe(&vehicle_cruise_sub, TOPIC_CRUISE);
+  topic_subscribe(&vehicle_target_sub, TOPIC_TARGET);
+}
 
-void ControlCallback(void *ptmr, void *callback_arg)
+/* Q15.16 to a saturated Q7.8 */
+static INT16S q78(INT32S x)
 {
-  OSSemPost(ControlSem);
+  x >>= 8;
+  return (INT16S)(x > 32767 ? 32767 : x < -32768 ? -32768 : x);
 }
 
-static INT8U calculate_throttle(int current_velocity, enum active gas_pedal)
+/* One telemetry record per step, see telemetry.h */
+static void vehicle_record(void)
 {
-  int i = 0;
-  int throttle;
-  int velocity_cur[] = {-5, 10, 20, 30, 40, 50, 60, 70, 80};
-  int speed_up[]     = {30, 30, 40, 50, 70, 70, 80, 80, 70};
-  int slow_down[]    = { 5,  5, 10, 20, 30, 40, 50, 60, 70};
-  
-  for (; i < 8; i++) {
-    if (velocity_cur[i] <= current_velocity && velocity_cur[i + 1] >= current_velocity) {
-      if (gas_pedal == on) {
-        throttle = (current_velocity - velocity_cur[i]) / (velocity_cur[i + 1] - velocity_cur[i])
-                  * (speed_up[i + 1] - speed_up[i]) + speed_up[i];
-      } else {
-        throttle = (current_velocity - velocity_cur[i]) / (velocity_cur[i + 1] - velocity_cur[i])
-                  * (slow_down[i + 1] - slow_down[i]) + slow_down[i];
-      }
-      
-    }
-  }
-
-  return throttle;
+  tel_record r;
+
+  topic_read(&vehicle_gas_sub, &vehicle_gas);
+  topic_read(&vehicle_top_gear_sub, &vehicle_top_gear);
+  topic_read(&vehicle_cruise_sub, &vehicle_cruise);
+  topic_read(&vehicle_target_sub, &vehicle_target);
+
+  r.flags = (vehicle_engine == on ? TEL_ENGINE : 0) | (vehicle_top_gear == on ? TEL_TOP_GEAR : 0)
+          | (vehicle_brake == on ? TEL_BRAKE : 0) | (vehicle_gas == on ? TEL_GAS : 0)
+          | (vehicle_cruise == on ? TEL_CRUISE : 0) | (vehicle_target > 0 ? TEL_CRUISING : 0)
+          | (mode_get() == MODE_DEGRADED ? TEL_DEGRADED : 0);
+  r.throttle = vehicle_throttle;
+  r.target = (INT8U)(vehicle_target < 0 ? 0 : vehicle_target > 255 ? 255 : vehicle_target);
+  /* replayed runs are compared record by record, so they get the logical time */
+  r.time = INPUT_REPLAY ? vehicle_time * 1000UL : cruise_clock_us();
+  r.position = (INT32U)((vehicle.position >> (VM_POS_FRAC_BITS - 8)) * 100 >> 8); /* [cm] */
+  r.velocity = q78(vehicle.velocity);
+  r.acceleration = q78(vehicle.acceleration);
+  tel_put(&r);
 }
 
-INT8U calculate_cruise(INT8U cruise_velocity, INT8U current_velocity)
+static void VehicleTask_step(void)
 {
-  INT8U throttle;
-  const int wind_factor = 1;
-  if (cruise_velocity > current_velocity) {
-    throttle = cruise_velocity * wind_factor
-              + 2 * wind_factor * (cruise_velocity - current_velocity)
-              / (CONTROL_PERIOD * CONTROL_PERIOD / 1000000) + 2;
-  } else {
-    throttle = cruise_velocity * wind_factor
-              - 2 * wind_factor * (current_velocity - cruise_velocity)
-              / (CONTROL_PERIOD * CONTROL_PERIOD / 1000000) - 1;
+  void* msg;
+  trace_tag tag;
+
+  /* Non-blocking read of mailbox: 
+     - message in mailbox: update throttle
+     - no message:         use old throttle
+     */
+  msg = OSMboxAccept(Mbox_Throttle); 
+  if (msg != NULL) {
+    vehicle_throttle = (INT8U)((trace_msg *)msg)->value;
+    trace_merge(&vehicle_tag, &((trace_msg *)msg)->tag);
   }
-}
+  /* Same for the brake signal that bypass the control law */
+  if (topic_read_traced(&vehicle_brake_sub, &vehicle_brake, &tag) == OS_ERR_NONE)
+    trace_merge(&vehicle_tag, &tag);
+  /* Same for the engine signal that bypass the control law */
+  if (topic_read_traced(&vehicle_engine_sub, &vehicle_engine, &tag) == OS_ERR_NONE)
+    trace_merge(&vehicle_tag, &tag);
+
+  if (VEHICLE_PROFILE)
+    PERF_BEGIN(PERFORMANCE_COUNTER_BASE, 2);
+  /* the step lasts until the next release, whose period ControlTask set just before */
+  if (vehicle.period != control_period)
+    vm_set_period(&vehicle, control_period);
+  vm_step(&vehicle, vehicle_throttle, vehicle_engine, vehicle_brake);
+  trace_sink(CHAIN_ACTUATION, &vehicle_tag);
+  if (VEHICLE_PROFILE) {
+    PERF_END(PERFORMANCE_COUNTER_BASE, 2);
+    if (++vehicle_steps % 100 == 0)
+      printf("vm_step: %lu cycles/step\n",
+          (unsigned long)(perf_get_section_time((void *)PERFORMANCE_COUNTER_BASE, 2) / vehicle_steps));
+  }
+  vehicle_velocity = vehicle.velocity;
+  OSMboxPost(Mbox_Velocity, (void *) &vehicle_velocity);
+
+  /* position, velocity, acceleration and throttle of every step */
+  vehicle_record();
+  vehicle_time += vehicle.period;
+
+  vehicle_speed = vm_velocity(&vehicle);
+  vehicle_position = vm_position(&vehicle);
+  topic_publish_traced(TOPIC_VELOCITY, &vehicle_speed, &vehicle_tag);
+  topic_publish_traced(TOPIC_POSITION, &vehicle_position, &vehicle_tag);
+
+  gflag_finish[2] = 1;
+} 
 
 /*
  * The task 'ControlTask' is the main task of the application. It reacts
- * on sensors and generates responses.
+ * on sensors and generates responses. The control law itself (throttle
+ * schedules and the PI cruise controller) is in cruise_control.c.
  */
 
-void ControlTask(void* pdata)
+static INT8U throttle; /* Value between 0 and 80, which is interpreted as between 0.0V and 8.0V */
+static INT32S current_velocity; /* Q15.16 [m/s] */
+static INT32U current_position; /* [m] */
+static trace_msg throttle_out;  /* posted to VehicleTask */
+static trace_msg out_control;   /* posted to DisplayTask */
+static trace_tag control_tag;   /* newest input sample */
+static INT16S target_speed;     /* [m/s], published for DisplayTask */
+static cruise_ctl control;
+static cruise_inputs control_in;
+static control_rate rate;
+static enum active control_brake; /* only for the rate */
+static topic_sub cruise_sub, gas_pedal_sub, engine_sub, top_gear_sub, control_position_sub;
+static topic_sub control_brake_sub;
+
+/* the rate of VehicleTask follows, so both stay in the same pipeline phase */
+typedef char control_rate_check[CONTROL_PERIOD == VEHICLE_PERIOD
+                                && CONTROL_PERIOD == RATE_DEFAULT_PERIOD ? 1 : -1];
+
+/*
+ * Next period of ControlTask and VehicleTask from the state of the drive
+ * (ADAPTIVE_RATE), see control_rate.h. Both timers were released in the
+ * same tick, so they are moved together and stay in phase. The frames of
+ * the cyclic executive are fixed, so it keeps CONTROL_PERIOD.
+ */
+static void control_rate_update(void)
 {
-  INT8U err;
-  INT8U throttle = 40; /* Value between 0 and 80, which is interpreted as between 0.0V and 8.0V */
-  void* msg;
-  INT16S* current_velocity;
-  INT16S previous_velocity;
-  INT16S cruise_velocity = 0;
-  int cruising = 0;
-  int out_control = 0;
+  INT16U period;
+
+  topic_read(&control_brake_sub, &control_brake);
+  period = rate_update(&rate, &control_in, control_brake, &control, current_velocity);
+  if (period == control_period)
+    return;
+  printf("rate: %u -> %u ms (%s)\n", control_period, period, rate_reason_name(rate.reason));
+  cruise_ctl_set_period(&control, period);
+  control_period = period;
+  hrt_set_period(&task_tmr[ControlTask_id], period * 1000UL);
+  hrt_set_period(&task_tmr[VehicleTask_id], period * 1000UL);
+  tm_set_period(ControlTask_id, period, RATE_DEADLINE(ControlTask_deadline, period));
+  tm_set_period(VehicleTask_id, period, RATE_DEADLINE(VehicleTask_deadline, period));
+}
 
-  enum active gas_pedal = off;
-  enum active top_gear = off;
-  enum active cruise_control = off; 
-  enum active engine = off;
+static void ControlTask_init(void)
+{
+  cruise_ctl_init(&control, CONTROL_PERIOD);
+  if (FEEDFORWARD)
+    cruise_ctl_set_feedforward(&control, road, CRUISE_FF_LOOKAHEAD);
+  throttle = 0;
+  current_velocity = 0;
+  current_position = 0;
+  control_in.gas_pedal = control_in.top_gear = off;
+  control_in.cruise_control = control_in.engine = off;
+  topic_subscribe(&cruise_sub, TOPIC_CRUISE);
+  topic_subscribe(&gas_pedal_sub, TOPIC_GAS_PEDAL);
+  topic_subscribe(&engine_sub, TOPIC_ENGINE);
+  topic_subscribe(&top_gear_sub, TOPIC_TOP_GEAR);
+  topic_subscribe(&control_position_sub, TOPIC_POSITION);
+  control_brake = off;
+  topic_subscribe(&control_brake_sub, TOPIC_BRAKE);
+  rate_init(&rate);
+}
 
-  printf("Control Task created!\n");
+static void ControlTask_step(void)
+{
+  void* msg;
+  trace_tag tag;
+  int cruising;
+
+  msg = OSMboxAccept(Mbox_Velocity);
+  if (msg != NULL)
+    current_velocity = *(INT32S*) msg;
+  /* published with the velocity, i.e. at the start of this vehicle step */
+  topic_read(&control_position_sub, &current_position);
+  if (topic_read_traced(&cruise_sub, &control_in.cruise_control, &tag) == OS_ERR_NONE)
+    trace_merge(&control_tag, &tag);
+  if (topic_read_traced(&gas_pedal_sub, &control_in.gas_pedal, &tag) == OS_ERR_NONE)
+    trace_merge(&control_tag, &tag);
+  if (topic_read_traced(&engine_sub, &control_in.engine, &tag) == OS_ERR_NONE)
+    trace_merge(&control_tag, &tag);
+  if (topic_read_traced(&top_gear_sub, &control_in.top_gear, &tag) == OS_ERR_NONE)
+    trace_merge(&control_tag, &tag);
+
+  cruising = control.cruising;
+  throttle = cruise_ctl_step(&control, &control_in, current_velocity, current_position);
+  if (control.cruising && !cruising)
+    printf("start cruising!\n");
+  if (ADAPTIVE_RATE && !CYCLIC_EXECUTIVE)
+    control_rate_update();
+
+  target_speed = (INT16S)((control.target + VM_ONE / 2) >> VM_FRAC_BITS);
+  topic_publish_traced(TOPIC_TARGET, &target_speed, &control_tag);
+
+  if (control.cruising) {
+    out_control.value = LED_GREEN_0;
+  } else {
+    out_control.value = 0;
+  }
 
-  while(1)
-  {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    msg = OSMboxPend(Mbox_Velocity, 1, &err);
-    if (err == OS_ERR_NONE)
-      current_velocity = (INT16S*) msg;
-    msg = OSMboxPend(Mbox_Cruise, 0, &err);
-    if (err == OS_ERR_NONE)
-      cruise_control = *((enum active *)msg);
-    msg = OSMboxPend(Mbox_GasPedal, 0, &err);
-    if (err == OS_ERR_NONE)
-      gas_pedal = *((enum active *)msg);
-    msg = OSMboxPend(Mbox_Engine_Control, 0, &err);
-    if (err == OS_ERR_NONE)
-      engine = *((enum active *)msg);
-    msg = OSMboxPend(Mbox_TopGear, 0, &err);
-    if (err == OS_ERR_NONE)
-      top_gear = *((enum active *)msg);
-    // Here you can use whatever technique or algorithm that you prefer to control
-    // the velocity via the throttle. There are no right and wrong answer to this controller, so
-    // be free to use anything that is able to maintain the cruise working properly. You are also
-    // allowed to store more than one sample of the velocity. For instance, you could define
-    //
-    // INT16S previous_vel;
-    // INT16S pre_previous_vel;
-    // ...
-    //
-    // If your control algorithm/technique needs them in order to function. 
-    if (cruise_control == on && cruising == 0 && top_gear == on && *current_velocity > 25) {
-      cruising = 1;
-      printf("start cruising!\n");
-      cruise_velocity = *current_velocity;
-      throttle = calculate_cruise(cruise_velocity, *current_velocity);
-    } else if (cruising && top_gear == on && cruise_control == on) {
-      throttle = calculate_cruise(cruise_velocity, *current_velocity);
-    } else if (engine == on) {
-      throttle = calculate_throttle(*current_velocity, gas_pedal);
-      cruise_velocity = 0;
-      cruising = 0;
-    } else {
-      throttle = 0;
-    }
+  throttle_out.value = throttle;
+  throttle_out.tag = control_tag;
+  OSMboxPost(Mbox_Throttle, (void *) &throttle_out);
+  if (boot_mark(BOOT_FIRST_CONTROL))
+    boot_print();
 
-    show_target_velocity(cruise_velocity);
+  out_control.tag = control_tag;
+  OSMboxPost(Mbox_ControlOut, (void *) &out_control);
 
-    if (cruising) {
-      out_control = LED_GREEN_0;
-    } else {
-      out_control = 0;
-    }
+  gflag_finish[3] = 1;
+}
 
-    // printf("current velocity: %d, cruise %d, throttle %d, top_gear %d, cruise_velocity %d\n",
-    //      *current_velocity, cruising, throttle, top_gear == on, cruise_velocity);
-  
-    err = OSMboxPost(Mbox_Throttle, (void *) &throttle);
 
-    err = OSMboxPost(Mbox_ControlOut, (void *) &out_control);
+/* 
+ * Display task receive message from buttons_pressed, switches_pressed, controltask
+ * and the velocities and position of the vehicle.
+ * Only the display task writes to the leds and seven segment displays, through the
+ * compositor of display.h which skips the registers whose content did not change.
+ */
 
-    gflag_finish[3] = 1;
+static topic_sub velocity_sub, position_sub, target_sub;
+static trace_tag display_tag[TRACE_CHAINS]; /* of what is shown, per chain */
 
-    OSSemPend(ControlSem, 0, &err);
+static void display_write(enum disp_reg reg, INT32U value)
+{
+  static const INT32U base[DISP_REGS] = {
+    DE2_PIO_GREENLED9_BASE, DE2_PIO_REDLED18_BASE, DE2_PIO_HEX_LOW28_BASE, DE2_PIO_HEX_HIGH28_BASE
+  };
 
-    previous_velocity = *current_velocity;
-  }
+  IOWR_ALTERA_AVALON_PIO_DATA(base[reg], value);
 }
 
-
-void DisplayCallback(void *ptmr, void *callback_arg)
+static void DisplayTask_init(void)
 {
-  OSSemPost(DisplaySem);
+  disp_init();
+  topic_subscribe(&velocity_sub, TOPIC_VELOCITY);
+  topic_subscribe(&position_sub, TOPIC_POSITION);
+  topic_subscribe(&target_sub, TOPIC_TARGET);
 }
-/* 
- * Display task receive message from buttons_pressed, switches_pressed, show_position, controltask.
- * Only allow display task to write to the green and red leds to avoid conflicts and blurring.
- */
 
-void DisplayTask(void)
+static void DisplayTask_step(void)
 {
-  INT8U err;
   void *msg;
-  int out_button;
-  int out_switch;
-  int out_position;
-  int out_control;
-  int greenled;
-  int redled;
-  int greenled_prev;
-  int redled_prev;
-
-  out_button = out_switch = out_position = out_control = 0;
-  greenled = greenled_prev = 0;
-  redled = redled_prev = 0;
-
-  printf("Display task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    OSSemPend(DisplaySem, 0, &err);
-    msg = OSMboxPend(Mbox_ButtonOut, 1, &err);
-    if (err == OS_ERR_NONE) {
-      out_button = *(int *)msg;
-    }
-    msg = OSMboxPend(Mbox_SwitchOut, 1, &err);
-    if (err == OS_ERR_NONE) {
-      out_switch = *(int *)msg;
-    }
-    msg = OSMboxPend(Mbox_PositionOut, 1, &err);
-    if (err == OS_ERR_NONE) {
-      out_position = *(int *)msg;
-    }
-    msg = OSMboxPend(Mbox_ControlOut, 1, &err);
-    if (err == OS_ERR_NONE) {
-      out_control = *(int *)msg;
-    }
-
-    greenled = out_button + out_control;
-    redled = out_switch + out_position;
-
-    if (greenled != greenled_prev)
-      IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE, greenled);
-    if (redled != redled_prev)
-      IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE, redled);
-
-    greenled_prev = greenled;
-    redled_prev = redled;
+  INT16S velocity;
+  INT32U position;
+  int leds;
+  trace_tag tag;
 
+  /* slowed down in degraded mode, see cruise_mode.h */
+  if (!mode_runs(DisplayTask_id, 0)) {
     gflag_finish[4] = 1;
+    return;
   }
-}
 
-void WatchdogCallback(void *ptmr, void *callback_arg)
-{
-  OSSemPost(WatchdogSem);
+  msg = OSMboxAccept(Mbox_ButtonOut);
+  if (msg != NULL) {
+    disp_set_bits(DISP_GREEN, LEDS_BUTTON, ((trace_msg *)msg)->value);
+    display_tag[CHAIN_BUTTON_LEDS] = ((trace_msg *)msg)->tag;
+  }
+  msg = OSMboxAccept(Mbox_SwitchOut);
+  if (msg != NULL) {
+    disp_set_bits(DISP_RED, LEDS_SWITCH, ((trace_msg *)msg)->value);
+    display_tag[CHAIN_SWITCH_LEDS] = ((trace_msg *)msg)->tag;
+  }
+  msg = OSMboxAccept(Mbox_ControlOut);
+  if (msg != NULL) {
+    disp_set_bits(DISP_GREEN, LEDS_CONTROL, ((trace_msg *)msg)->value);
+    trace_merge(&display_tag[CHAIN_TARGET], &((trace_msg *)msg)->tag);
+  }
+  if (topic_read_traced(&velocity_sub, &velocity, &tag) == OS_ERR_NONE) {
+    disp_set_number(DISP_HEX_LOW, velocity);
+    display_tag[CHAIN_VELOCITY] = tag;
+  }
+  if (topic_read_traced(&target_sub, &velocity, &tag) == OS_ERR_NONE) {
+    disp_set_number(DISP_HEX_HIGH, velocity);
+    trace_merge(&display_tag[CHAIN_TARGET], &tag);
+  }
+  if (topic_read(&position_sub, &position) == OS_ERR_NONE) {
+    show_position(position, &leds);
+    disp_set_bits(DISP_RED, LEDS_POSITION, leds);
+  }
+
+  disp_flush(display_write);
+  trace_sink(CHAIN_BUTTON_LEDS, &display_tag[CHAIN_BUTTON_LEDS]);
+  trace_sink(CHAIN_SWITCH_LEDS, &display_tag[CHAIN_SWITCH_LEDS]);
+  trace_sink(CHAIN_TARGET, &display_tag[CHAIN_TARGET]);
+  trace_sink(CHAIN_VELOCITY, &display_tag[CHAIN_VELOCITY]);
+
+  gflag_finish[4] = 1;
 }
 
 /* Watchdog task allow to be reset during a hyperperiod.
  * If reset, it means all tasks finish running within a hyperperiod.
  * If not reset, it means there is task that have not finish running during a hyperperiod.
+ *
+ * OverloadDetection posts the reset at the end of a hyperperiod, the
+ * watchdog checks for it at the start of the next one instead of waiting
+ * for it, so it never blocks the tasks it supervises.
  */
 
-void WatchdogTask(void)
+static int watchdog_armed;
+static INT32U watchdog_misses;
+static INT32U watchdog_periods;
+
+static load_gen extraload; /* of ExtraloadTask, the headroom search sets its load */
+static headroom hr;
+static INT32U hr_periods;  /* into the current probe */
+static int hr_missed;
+
+static void headroom_step(int overload, int missed);
+
+static void WatchdogTask_init(void)
 {
-  int reset = 0;
-  void *msg;
-  INT8U err;
-  printf("Watchdog task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    PERF_RESET(PERFORMANCE_COUNTER_BASE);
-    PERF_START_MEASURING(PERFORMANCE_COUNTER_BASE);
-    PERF_BEGIN(PERFORMANCE_COUNTER_BASE, 1);
-    msg = OSMboxPend(Mbox_WatchdogReset, HYPERPERIOD - 10, &err); /* wait for reset */
-    if (err == OS_ERR_NONE) {
-      reset = *(int *)msg;
-      int i = 0;
-      for (; i < 5; i++) {
-        gflag_finish[i] = 0;
-      }
-    }
-    if (reset == 0) {
-      printf("Overload detected!\n"); /* no reset during waiting time, overload detected */
-    }
-    PERF_END(PERFORMANCE_COUNTER_BASE, 1);
-    if (DEBUG)
-      perf_print_formatted_report(PERFORMANCE_COUNTER_BASE, 50000000, 1, "SECTION"); /* print the waiting time */
+  watchdog_armed = 0;
+  watchdog_misses = 0;
+  watchdog_periods = 0;
+  if (HEADROOM_TEST)
+    headroom_init(&hr, HEADROOM_RESOLUTION, HEADROOM_TEST);
+}
 
-    OSSemPend(WatchdogSem, 0, &err);
-    reset = 0;
+static void WatchdogTask_step(void)
+{
+  void *msg;
+  int overload, missed, searching;
+  INT32U slack;
+
+  PERF_BEGIN(PERFORMANCE_COUNTER_BASE, 1);
+  msg = OSMboxAccept(Mbox_WatchdogReset);
+  overload = (msg == NULL && watchdog_armed);
+  if (overload) {
+    printf("Overload detected!\n"); /* no reset during the last hyperperiod, overload detected */
+  }
+  watchdog_armed = 1; /* nothing to check before the first hyperperiod */
+  PERF_END(PERFORMANCE_COUNTER_BASE, 1);
+
+  /* which task was late, see task_monitor.h */
+  watchdog_periods++;
+  missed = tm_misses() != watchdog_misses;
+  watchdog_misses = tm_misses();
+  searching = HEADROOM_TEST && !headroom_done(&hr);
+  if (searching) {
+    /* misses are expected while searching, only the result is printed */
+    headroom_step(overload, missed);
+  } else if (overload || missed
+             || (MONITOR_SUMMARY && watchdog_periods % MONITOR_SUMMARY == 0)) {
+    tm_print_summary();
+    if (DEGRADATION)
+      mode_print();
+    if (ADAPTIVE_RATE && !CYCLIC_EXECUTIVE)
+      rate_print(&rate);
   }
+
+  /* one window of the CPU accounting per hyperperiod, see cpu_account.h */
+  cpu_window();
+  if (CPU_EXPORT && watchdog_periods % CPU_EXPORT == 0)
+    cpu_print(CPU_WINDOWS);
+  if (TRACE_EXPORT && watchdog_periods % TRACE_EXPORT == 0)
+    trace_print();
+
+  /* shed or restore the low criticality tasks, see cruise_mode.h */
+#if OS_APP_HOOKS_EN > 0
+  slack = (INT32U)cpu_load(OS_LOWEST_PRIO, 1) * HYPERPERIOD; /* per mille of ms in us */
+#else
+  slack = MODE_SLACK_UNKNOWN;
+#endif
+  if (DEGRADATION && !searching)
+    mode_update(overload || missed, slack);
+  if (DEBUG)
+    perf_print_formatted_report(PERFORMANCE_COUNTER_BASE, 50000000, 1, "SECTION"); /* print the waiting time */
+  if (DEBUG)
+    topic_print_stats();
+  if (DEBUG)
+    disp_print_stats();
+  if (DEBUG)
+    tel_print_stats();
 }
 
-void OverloadCallback(void *ptmr, void *callback_arg)
+/*
+ * One hyperperiod of the headroom search: ExtraloadTask runs
+ * headroom_probe() per mille for HEADROOM_SETTLE + HEADROOM_PROBE
+ * hyperperiods, the load passes if no deadline was missed and no overload
+ * was detected after the settling time. The load of a release that is
+ * still running when the load changes is not counted against the new one.
+ */
+static void headroom_step(int overload, int missed)
 {
-  OSSemPost(OverloadSem);
+  if (++hr_periods > HEADROOM_SETTLE && (overload || missed))
+    hr_missed = 1;
+  if (hr_periods < HEADROOM_SETTLE + HEADROOM_PROBE && !hr_missed)
+    return;
+
+  headroom_report(&hr, hr_missed);
+  hr_periods = 0;
+  hr_missed = 0;
+  if (headroom_done(&hr)) {
+    extraload.base = 0;
+    headroom_print(&hr);
+    tm_print_summary();
+  } else {
+    extraload.base = headroom_probe(&hr);
+  }
 }
 
 /* Overload detection task run after all other tasks have finish running in a hyperperiod.
  * Overload detection task reset watchdog to tell it all tasks have finish running.
  */
 
-void OverloadDetection(void)
+static int overload_reset = 1;
+
+static void OverloadDetection_init(void)
+{
+}
+
+static void OverloadDetection_step(void)
 {
-  int reset = 1;
   INT8U err;
-  printf("Overload detection task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
+  int i, finished = 1;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  /* only the tasks released in this hyperperiod have to be done, ControlTask
+   * and VehicleTask skip hyperperiods at a long ADAPTIVE_RATE period */
+  OS_ENTER_CRITICAL();
+  for (i = 0; i < 5; i++) {
+    if (task_released[gflag_task[i]] && !gflag_finish[i])
+      finished = 0;
+    task_released[gflag_task[i]] = 0;
+    gflag_finish[i] = 0;
+  }
+  OS_EXIT_CRITICAL();
 
-    OSSemPend(ExtraloadFinishSem, 0, &err);
+  /* ExtraloadTask runs first (CRUISE_PRECEDENCE), so it has posted unless it overran */
+  if (OSSemAccept(ExtraloadFinishSem) > 0 && finished) {
+    err = OSMboxPost(Mbox_WatchdogReset, (void *)&overload_reset);
     if (err != OS_ERR_NONE && DEBUG) {
-      printf("OSSemPend error! line, %d error, %u\n", __LINE__, err);
-    }
-
-    if (gflag_finish[0] && gflag_finish[1] && gflag_finish[2] && gflag_finish[3] && gflag_finish[4]) {
-      err = OSMboxPost(Mbox_WatchdogReset, (void *)&reset);
-      if (err != OS_ERR_NONE && DEBUG) {
-        printf("OSMboxPost error! line, %d\n", __LINE__);
-      }
+      printf("OSMboxPost error! line, %d\n", __LINE__);
     }
-      
-    OSSemPend(OverloadSem, 0, &err);
   }
 }
 
-void addload(int time)
-{
-  int i, j;
-  i = j = 0;
-  for (; i < time; i++) {
-    for (; j < CALIBRATION; j++);
-  }
-}
+/* Extraload task add an extra load to the system.
+ * Read the value of sw4-sw9 to calculate the amount of extra load: the
+ * binary value of the switches in percent of EXTRALOAD_PERIOD, unless
+ * EXTRALOAD_MODE selects another profile.
+ */
+
+static INT32U extraload_time; /* logical time of the release [ms] */
 
-void ExtraloadCallback(void *ptmr, void *callback_arg)
+static void ExtraloadTask_init(void)
 {
-  OSSemPost(ExtraloadSem);
+  /* WatchdogTask, created and initialized before, has started the search */
+  if (HEADROOM_TEST)
+    load_gen_init(&extraload, LOAD_CONST, headroom_probe(&hr), 0, 0, 0);
+  else
+    load_gen_init(&extraload, EXTRALOAD_MODE, EXTRALOAD_BASE, EXTRALOAD_AMPLITUDE,
+                  EXTRALOAD_LENGTH, EXTRALOAD_SEED);
 }
 
-/* Extraload task add an extra load to the system.
- * Read the value of sw4-sw9 to calculate the amount of extra load.
- */
-
-void ExtraloadTask(void)
+static void ExtraloadTask_step(void)
 {
   int btn_reg;
   int workload = 0;
-  int extraload;
+  INT32U load_us;
   INT8U err;
-  printf("Extraload task created!\n");
-  while (1) {
-    if (DEBUG)
-      printf("%s\n", __func__);
-    btn_reg = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE);
-    btn_reg = btn_reg & 0xffffffff;
-
-    if (btn_reg & SW4) {
-      workload += 1;
-    }
-    if (btn_reg & SW5) {
-      workload += 2;
-    }
-    if (btn_reg & SW6) {
-      workload += 4;
-    }
-    if (btn_reg & SW7) {
-      workload += 8;
-    }
-    if (btn_reg & SW8) {
-      workload += 16;
-    }
-    if (btn_reg & SW9) {
-      workload += 32;
-    }
 
-    extraload = workload * CALIBRATION;
-    addload(extraload);
+  btn_reg = switches_pressed(extraload_time);
+  extraload_time += EXTRALOAD_PERIOD;
+  btn_reg = btn_reg & 0xffffffff;
 
-    OSSemPost(ExtraloadFinishSem);
-    
-    OSSemPend(ExtraloadSem, 0, &err);
-    if (err != OS_ERR_NONE) {
-      printf("OSSemPend error! line, %d error, %u\n", __LINE__, err);
-    }
-    OSSemSet(ExtraloadSem, 0, &err);
-    if (err != OS_ERR_NONE) {
-      printf("OSSemSet error! line, %d\n", __LINE__);
-    }
-    workload = 0;
+  if (btn_reg & SW4) {
+    workload += 1;
   }
-}
-
-/* 
- * The task 'StartTask' creates all other tasks kernel objects and
- * deletes itself afterwards.
- */ 
-
-void StartTask(void* pdata)
-{
-  INT8U err;
-  void* context;
-
-  static alt_alarm alarm;     /* Is needed for timer ISR function */
-
-  /* Base resolution for SW timer : HW_TIMER_PERIOD ms */
-  delay = alt_ticks_per_second() * HW_TIMER_PERIOD / 1000; 
-  printf("delay in ticks %d\n", delay);
-
-  /* 
-   * Create Hardware Timer with a period of 'delay' 
-   */
-  if (alt_alarm_start (&alarm,
-        delay,
-        alarm_handler,
-        context) < 0)
-  {
-    printf("No system clock available!n");
+  if (btn_reg & SW5) {
+    workload += 2;
   }
-
-  /* 
-   * Create and start Software Timer 
-   */
-  VehicleTmr = OSTmrCreate(0, VEHICLE_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-			  &VehicleCallback, NULL, "VehicleTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
+  if (btn_reg & SW6) {
+    workload += 4;
   }
-
-  ControlTmr = OSTmrCreate(0, CONTROL_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &ControlCallback, NULL, "ControlTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
+  if (btn_reg & SW7) {
+    workload += 8;
   }
-
-  ButtonTmr = OSTmrCreate(0, BUTTONIO_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &ButtonIOCallback, NULL, "ButtonTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
+  if (btn_reg & SW8) {
+    workload += 16;
   }
-  
-  SwitchTmr = OSTmrCreate(0, SWITCHIO_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &SwitchIOCallback, NULL, "SwitchTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
+  if (btn_reg & SW9) {
+    workload += 32;
   }
 
-  DisplayTmr = OSTmrCreate(0, DISPLAY_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &DisplayCallback, NULL, "DisplayTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
-  }
+  /* the load is shed in degraded mode, the handshake with OverloadDetection is not */
+  load_us = (INT32U)load_gen_next(&extraload, workload) * EXTRALOAD_PERIOD; /* per mille of ms in us */
+  if (mode_runs(ExtraloadTask_id, load_us))
+    load_burn_us(load_us);
 
-  WatchdogTmr = OSTmrCreate(0, WATCHDOG_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &WatchdogCallback, NULL, "WatchdogTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
-  }
+  OSSemPost(ExtraloadFinishSem);
 
-  OverloadTmr = OSTmrCreate(0, OVERLOAD_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &OverloadCallback, NULL, "OverloadTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
+  /* drop the releases missed while the load ran */
+  if (!CYCLIC_EXECUTIVE) {
+    OSSemSet(TASK_SEM(ExtraloadTask), 0, &err);
+    if (err != OS_ERR_NONE) {
+      printf("OSSemSet error! line, %d\n", __LINE__);
+    }
+    tm_drop(ExtraloadTask_id);
   }
+}
 
-  ExtraloadTmr = OSTmrCreate(0, EXTRALOAD_PERIOD / 100, OS_TMR_OPT_PERIODIC,
-        &ExtraloadCallback, NULL, "ExtraloadTmr", &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer create failed! line, %d\n", __LINE__);
-  }
+/* Telemetry task streams the records of VehicleTask from the RAM ring,
+ * at the lowest priority so the recording never costs the loop a printf.
+ */
 
-  OSTmrStart(VehicleTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+static void telemetry_write(const INT8U *buf, INT16U len)
+{
+  fwrite(buf, 1, len, stdout);
+}
 
-  OSTmrStart(ControlTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+static void TelemetryTask_init(void)
+{
+}
 
-  OSTmrStart(ButtonTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+static void TelemetryTask_step(void)
+{
+  /* slowed down in degraded mode, the ring keeps the records meanwhile */
+  if (!TELEMETRY_FLUSH || !mode_runs(TelemetryTask_id, 0))
+    return;
+  if (tel_flush(telemetry_write, TELEMETRY_FLUSH))
+    fflush(stdout);
+}
 
-  OSTmrStart(SwitchTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+/*
+ * Everything StartTask creates for the tasks of CRUISE_TASKS
+ */
+typedef struct {
+  const char *name;
+  void (*init)(void);
+  void (*step)(void);
+  OS_STK *stack;
+  INT32U stack_size;
+  INT8U prio;
+  INT16U period; /* [ms] */
+} task_desc;
+
+#define TASK_DESC(name, period, deadline, budget, crit, stack) \
+  {#name, name##_init, name##_step, name##_Stack, stack, TASK_PRIO(name), period},
+static const task_desc task_table[TASK_COUNT] = { CRUISE_TASKS(TASK_DESC) };
+#undef TASK_DESC
+
+/* release offsets of the pipeline stages [ms], see CRUISE_PIPELINE */
+static const INT16U task_offset[TASK_COUNT] = TASK_OFFSETS;
+
+static OS_EVENT **const mailboxes[] = {
+  &Mbox_Throttle, &Mbox_Velocity, &Mbox_ButtonOut, &Mbox_SwitchOut,
+  &Mbox_ControlOut, &Mbox_WatchdogReset
+};
 
-  OSTmrStart(DisplayTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+/* Releases the task 'arg' (its entry in task_table), runs in the timer ISR */
+static void TaskTimerCallback(void *arg)
+{
+  INT8U id = (const task_desc *)arg - task_table;
 
-  OSTmrStart(WatchdogTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+  tm_release(id);
+  task_released[id] = 1;
+  OSSemPost(task_sem[id]);
+}
 
-  OSTmrStart(OverloadTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+/* Starts the minor frame of the cyclic executive */
+static void FrameTimerCallback(void *arg)
+{
+  OSSemPost(FrameSem);
+}
 
-  OSTmrStart(ExtraloadTmr, &err);
-  if (err != OS_ERR_NONE) {
-    printf("timer start failed! line, %d\n", __LINE__);
-  }
+/*
+ * Body of every task of CRUISE_TASKS: released once when it is created and
+ * then by its SW timer. 'pdata' is its entry in task_table.
+ */
+static void periodic_task(void* pdata)
+{
+  const task_desc *t = (const task_desc *)pdata;
+  INT8U id = t - task_table;
+  INT8U err;
 
-  /*
-   * Creation of Kernel Objects
-   */
-  VehicleSem = OSSemCreate(0);
-  if (VehicleSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
+  t->init();
+  printf("%s created!\n", t->name);
+  tm_release(id);
+  while (1) {
+    if (DEBUG)
+      printf("%s\n", t->name);
+    tm_start(id);
+    t->step();
+    tm_finish(id);
+    OSSemPend(task_sem[id], 0, &err);
   }
+}
 
-  ControlSem = OSSemCreate(0);
-  if (ControlSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
-  }
+/*
+ * Cyclic executive mode: frame_tmr posts FrameSem once per minor frame
+ * (HW_TIMER_PERIOD) and CyclicExecutive runs the steps of the tasks released
+ * in that frame, see cyclic_exec.h.
+ */
+static cyclic_exec ce;
+static ce_task ce_tasks[TASK_COUNT];
+
+/* every task is released at the start of a minor frame */
+#define TASK_FRAME_CHECK(name, period, deadline, budget, crit, stack) \
+  typedef char name##_frame_check[(!CYCLIC_EXECUTIVE || (period) % HW_TIMER_PERIOD == 0) ? 1 : -1];
+CRUISE_TASKS(TASK_FRAME_CHECK)
+#undef TASK_FRAME_CHECK
+
+/* step functions with the task monitor hooks */
+#define TASK_CE_STEP(name, period, deadline, budget, crit, stack) \
+  static void name##_ce_step(void) { tm_start(name##_id); name##_step(); tm_finish(name##_id); }
+CRUISE_TASKS(TASK_CE_STEP)
+#undef TASK_CE_STEP
+#define TASK_CE_STEP(name, period, deadline, budget, crit, stack) name##_ce_step,
+static void (*const ce_steps[TASK_COUNT])(void) = { CRUISE_TASKS(TASK_CE_STEP) };
+#undef TASK_CE_STEP
+
+static void CyclicExecutive(void* pdata)
+{
+  INT8U err, i;
 
-  ButtonSem = OSSemCreate(0);
-  if (ButtonSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
+  printf("Cyclic executive created!\n");
+  while (1) {
+    for (i = 0; i < ce.count[ce.frame]; i++) {
+      tm_release(ce.order[ce.frame][i]);
+      task_released[ce.order[ce.frame][i]] = 1;
+    }
+    if (ce_run_frame(&ce))
+      printf("Frame overrun!\n");
+    if (DEBUG && ce.frame == 0)
+      ce_print_stats(&ce);
+    OSSemPend(FrameSem, 0, &err);
   }
+}
 
-  SwitchSem = OSSemCreate(0);
-  if (SwitchSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
-  }
+/* 
+ * The task 'StartTask' creates all other tasks kernel objects and
+ * deletes itself afterwards. Everything is created in dependency order:
+ * first the objects the tasks block on, then the tasks, and last the
+ * timers that release them. StartTask has a higher priority than all
+ * tasks, so none of them runs before StartTask deletes itself.
+ */ 
 
-  DisplaySem = OSSemCreate(0);
-  if (DisplaySem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
-  }
+void StartTask(void* pdata)
+{
+  INT8U err;
+  void* context;
+  int i;
+  INT32U base;
 
-  WatchdogSem = OSSemCreate(0);
-  if (WatchdogSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
-  }
+  static alt_alarm alarm;     /* Is needed for timer ISR function */
 
-  OverloadSem = OSSemCreate(0);
-  if (OverloadSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
+  /* Performance counter runs freely from now on, see cruise_clock.h */
+  cruise_clock_init();
+  boot_mark(BOOT_START);
+  cpu_account_init();
+  /* before any other task or the timers run */
+  printf("load calibration: %lu loops/ms\n", (unsigned long)load_calibrate());
+
+#ifndef HIGH_RES_TIMER_BASE
+  /* the wheel is driven by the system clock, every period and offset
+   * would run at the wrong rate on a tick that does not divide it */
+  delay = alt_ticks_per_second() * HRT_TICK_US / 1000000;
+  if (delay == 0 || delay * 1000000 != alt_ticks_per_second() * HRT_TICK_US) {
+    printf("HRT_TICK_US is no multiple of the system tick, needs a HIGH_RES_TIMER! Stopped.\n");
+    OSTaskDel(OS_PRIO_SELF);
   }
+#endif
 
-  ExtraloadSem = OSSemCreate(0);
-  if (ExtraloadSem == NULL) {
-    printf("semaphore create failed! line, %d\n", __LINE__);
+  /*
+   * Creation of Kernel Objects
+   */
+  if (CYCLIC_EXECUTIVE) {
+    FrameSem = OSSemCreate(0);
+    if (FrameSem == NULL) {
+      printf("semaphore create failed! line, %d\n", __LINE__);
+    }
+  } else {
+    for (i = 0; i < TASK_COUNT; i++) {
+      task_sem[i] = OSSemCreate(0);
+      if (task_sem[i] == NULL) {
+        printf("semaphore create failed! task %s\n", task_table[i].name);
+      }
+    }
   }
-
   ExtraloadFinishSem = OSSemCreate(0);
   if (ExtraloadFinishSem == NULL) {
     printf("semaphore create failed! line, %d\n", __LINE__);
   }
 
+  for (i = 0; i < sizeof(mailboxes) / sizeof(mailboxes[0]); i++) {
+    *mailboxes[i] = OSMboxCreate((void *)0);
+    if (*mailboxes[i] == NULL) {
+      printf("mailbox create failed! %d\n", i);
+    }
+  }
 
-  // Mailboxes
-  Mbox_Throttle = OSMboxCreate((void*) 0); /* Empty Mailbox - Throttle */
-  Mbox_Velocity = OSMboxCreate((void*) 0); /* Empty Mailbox - Velocity */
-  Mbox_Brake = OSMboxCreate((void*) 0); /* Empty Mailbox - Break */
-  Mbox_Engine_Control = OSMboxCreate((void*) 1); /* Empty Mailbox - Engine - to Control task */
-  Mbox_Engine_Vehicle = OSMboxCreate((void*) 1); /* Empty Mailbox - Engine - to Vehicle task */
-  Mbox_Cruise = OSMboxCreate((void *) 0);
-  Mbox_GasPedal = OSMboxCreate((void *) 0);
-  Mbox_TopGear = OSMboxCreate((void *) 0);
-  Mbox_ButtonOut = OSMboxCreate((void *)0);
-  Mbox_SwitchOut = OSMboxCreate((void *)0);
-  Mbox_PositionOut = OSMboxCreate((void *)0);
-  Mbox_ControlOut = OSMboxCreate((void *)0);
-  Mbox_WatchdogReset = OSMboxCreate((void *)0);
+  // Topics (engine, top gear, brake, gas pedal, cruise), see cruise_topics.h
+  topic_bus_init();
+  tm_init();
+  trace_init();
+  tel_init(TELEMETRY_DELTA);
+  if (INPUT_REPLAY) {
+    replay_init(replay_script, REPLAY_SCRIPT_LENGTH);
+    printf("replay: %u states, %lu ms\n", (unsigned)REPLAY_SCRIPT_LENGTH, (unsigned long)replay_length());
+  }
+  mode_init();
+  boot_mark(BOOT_OBJECTS);
 
   /*
-   * Create statistics task
+   * Create statistics task. OSStatInit() waits 100 ms to calibrate the
+   * idle counter, so it is only done when OSCPUUsage is needed.
    */
-
-  OSStatInit();
+  if (BOOT_STAT_INIT)
+    OSStatInit();
 
   /* 
    * Creating Tasks in the system 
    */
+  if (CYCLIC_EXECUTIVE) {
+    for (i = 0; i < TASK_COUNT; i++) {
+      ce_tasks[i].name = task_table[i].name;
+      ce_tasks[i].step = ce_steps[i];
+      ce_tasks[i].period = task_table[i].period;
+      ce_tasks[i].prio = task_table[i].prio;
+      task_table[i].init();
+    }
+    /* without a schedule the frame counter of 'ce' is not set up, so the
+     * executive is not created and no task runs */
+    if (ce_init(&ce, ce_tasks, TASK_COUNT, HW_TIMER_PERIOD, HYPERPERIOD) != 0) {
+      printf("no cyclic schedule for the task set!\n");
+    } else {
+      ce_print_stats(&ce);
+
+      err = OSTaskCreateExt(CyclicExecutive, NULL,
+          &CyclicExecutive_Stack[TASK_STACKSIZE - 1],
+          TASK_PRIO_BASE,
+          TASK_PRIO_BASE,
+          CyclicExecutive_Stack,
+          TASK_STACKSIZE,
+          (void *) 0,
+          OS_TASK_OPT_STK_CHK);
+      if (err != OS_ERR_NONE) {
+        printf("task create failed! error %u\n", err);
+      }
+    }
+  } else {
+    for (i = 0; i < TASK_COUNT; i++) {
+      const task_desc *t = &task_table[i];
+
+      err = OSTaskCreateExt(periodic_task, (void *)t,
+          &t->stack[t->stack_size - 1], // Pointer to top of task stack
+          t->prio,
+          t->prio,
+          t->stack,
+          t->stack_size,
+          (void *) 0,
+          OS_TASK_OPT_STK_CHK);
+      if (err != OS_ERR_NONE) {
+        printf("task create failed! task %s error %u\n", t->name, err);
+      }
+    }
+  }
+  boot_mark(BOOT_TASKS);
 
+  /* 
+   * Start the Software Timers. All get the same base, so they start at
+   * the same phase; they first expire one period after it (plus the
+   * pipeline offset of the task), the first release of every task was its
+   * creation.
+   */
+  hrt_init();
+  base = hrt_now();
+  if (CYCLIC_EXECUTIVE) {
+    hrt_timer_init(&frame_tmr, FrameTimerCallback, NULL);
+    hrt_start(&frame_tmr, base, HW_TIMER_PERIOD * 1000UL, HW_TIMER_PERIOD * 1000UL);
+  } else {
+    for (i = 0; i < TASK_COUNT; i++) {
+      INT32U period = task_table[i].period * 1000UL;
 
-  err = OSTaskCreateExt(
-      ControlTask, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &ControlTask_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      CONTROLTASK_PRIO,
-      CONTROLTASK_PRIO,
-      (void *)&ControlTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
+      hrt_timer_init(&task_tmr[i], TaskTimerCallback, (void *)&task_table[i]);
+      hrt_start(&task_tmr[i], base, period + task_offset[i] * 1000UL, period);
+    }
+  }
 
-  err = OSTaskCreateExt(
-      VehicleTask, // Pointer to task code
-      NULL,        // Pointer to argument that is
-      // passed to task
-      &VehicleTask_Stack[TASK_STACKSIZE-1], // Pointer to top
-      // of task stack
-      VEHICLETASK_PRIO,
-      VEHICLETASK_PRIO,
-      (void *)&VehicleTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      ButtonIO,
-      NULL,
-      &ButtonIO_Stack[TASK_STACKSIZE - 1],
-      BUTTONIO_PRIO,
-      BUTTONIO_PRIO,
-      (void *)&ButtonIO_Stack[0],
-      TASK_STACKSIZE,
-      (void *)0,
-      OS_TaskStatStkChk);
-
-  err = OSTaskCreateExt(
-      SwitchIO,
-      NULL,
-      &SwitchIO_Stack[TASK_STACKSIZE - 1],
-      SWITCHIO_PRIO,
-      SWITCHIO_PRIO,
-      (void *)&SwitchIO_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt(
-      DisplayTask,
-      NULL,
-      &DisplayTask_Stack[TASK_STACKSIZE - 1],
-      DISPLAYTASK_PRIO,
-      DISPLAYTASK_PRIO,
-      (void *)&DisplayTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt (
-      WatchdogTask,
-      NULL,
-      &WatchdogTask_Stack[TASK_STACKSIZE - 1],
-      WATCHDOGTASK_PRIO,
-      WATCHDOGTASK_PRIO,
-      (void *)&WatchdogTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt (
-      OverloadDetection,
-      NULL,
-      &OverloadDetection_Stack[TASK_STACKSIZE - 1],
-      OVERLOADDETECTION_PRIO,
-      OVERLOADDETECTION_PRIO,
-      (void *)&OverloadDetection_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
-
-  err = OSTaskCreateExt (
-      ExtraloadTask,
-      NULL,
-      &ExtraloadTask_Stack[TASK_STACKSIZE - 1],
-      EXTRALOADTASK_PRIO,
-      EXTRALOADTASK_PRIO,
-      (void *)&ExtraloadTask_Stack[0],
-      TASK_STACKSIZE,
-      (void *) 0,
-      OS_TASK_OPT_STK_CHK);
+  /* 
+   * Create Hardware Timer with a period of HRT_TICK_US
+   */
+#ifdef HIGH_RES_TIMER_BASE
+  delay = 0;
+  if (high_res_timer_start() < 0)
+  {
+    printf("No high resolution timer available!\n");
+  }
+#else
+  /* 'delay' ticks of the system clock per HRT_TICK_US, checked above */
+  if (alt_alarm_start (&alarm,
+        delay,
+        alarm_handler,
+        context) < 0)
+  {
+    printf("No system clock available!n");
+  }
+#endif
+  boot_mark(BOOT_TIMERS);
 
-  printf("All Tasks and Kernel Objects generated!\n");
+  printf("All Tasks and Kernel Objects generated! delay in ticks %d\n", delay);
   
   /* Task deletes itself */
 
@@ -0,0 +1,184 @@
+/* Task set of the cruise control application
+ *
+ * Description:
+ *
+ *   CRUISE_TASKS declares every periodic task once: its entry function,
+ *   period, relative deadline, execution budget, criticality and stack
+ *   size. The priorities are not written down anywhere, they are derived
+ *   from the table at compile time:
+ *
+ *     - deadline monotonic: the shorter the deadline, the higher the
+ *       priority (lower number in uC/OS-II),
+ *     - equal deadlines are ordered rate monotonic by period,
+ *     - what is still equal keeps the order of the table.
+ *
+ *   The derived priorities are the enum constants TASK_PRIO(name), numbered
+ *   densely from TASK_PRIO_BASE. The build fails if a deadline exceeds its
+ *   period, a derived priority collides with StartTask or a uC/OS-II task,
+ *   or a pair in CRUISE_PRECEDENCE does not come out in the declared order.
+ *
+ *   The host tools (host/rta.c) include this header too, so the analysis
+ *   always sees the task set that runs on the board.
+ */
+#ifndef CRUISE_TASKS_H
+#define CRUISE_TASKS_H
+
+#include "hr_timer.h"
+
+#define HW_TIMER_PERIOD 100 /* 100ms, minor frame of the cyclic executive */
+
+#define TASK_STACKSIZE 2048
+
+#define STARTTASK_PRIO 5
+#define TASK_PRIO_BASE 6  /* priority of the most urgent periodic task */
+
+// Task Periods
+#define HYPERPERIOD       300
+#define CONTROL_PERIOD    300
+#define VEHICLE_PERIOD    300
+#define BUTTONIO_PERIOD   100
+#define SWITCHIO_PERIOD   300
+#define DISPLAY_PERIOD    300
+#define WATCHDOG_PERIOD   HYPERPERIOD
+#define OVERLOAD_PERIOD   HYPERPERIOD
+#define EXTRALOAD_PERIOD  HYPERPERIOD
+#define TELEMETRY_PERIOD  HYPERPERIOD
+
+enum task_criticality {
+  TASK_CRIT_HIGH,   /* safety: brake, watchdog, control loop */
+  TASK_CRIT_MEDIUM, /* degrades comfort when late */
+  TASK_CRIT_LOW     /* may be shed under overload */
+};
+
+/*
+ * X(entry, period [ms], deadline [ms], budget [us], criticality, stack size)
+ *
+ * The budget is the execution time a release may take before the task
+ * monitor counts an overrun, 0 for none (ExtraloadTask takes whatever the
+ * switches ask for).
+ *
+ * The watchdog has a deadline of one timer period, so it ranks right after
+ * the buttons and ahead of the tasks it supervises. ControlTask and
+ * VehicleTask have to finish in the first part of their period to keep the
+ * sampling-to-actuation delay of the loop short.
+ */
+#define CRUISE_TASK_TABLE(X, a)                                                                   \
+  X(a, WatchdogTask,      WATCHDOG_PERIOD,  HW_TIMER_PERIOD, 1000, TASK_CRIT_HIGH,   TASK_STACKSIZE) \
+  X(a, ButtonIO,          BUTTONIO_PERIOD,  BUTTONIO_PERIOD, 1000, TASK_CRIT_HIGH,   TASK_STACKSIZE) \
+  X(a, ControlTask,       CONTROL_PERIOD,   200,             2000, TASK_CRIT_HIGH,   TASK_STACKSIZE) \
+  X(a, VehicleTask,       VEHICLE_PERIOD,   200,             2000, TASK_CRIT_HIGH,   TASK_STACKSIZE) \
+  X(a, SwitchIO,          SWITCHIO_PERIOD,  SWITCHIO_PERIOD, 1000, TASK_CRIT_MEDIUM, TASK_STACKSIZE) \
+  X(a, DisplayTask,       DISPLAY_PERIOD,   DISPLAY_PERIOD,  2000, TASK_CRIT_LOW,    TASK_STACKSIZE) \
+  X(a, ExtraloadTask,     EXTRALOAD_PERIOD, HYPERPERIOD,     0,    TASK_CRIT_LOW,    TASK_STACKSIZE) \
+  X(a, OverloadDetection, OVERLOAD_PERIOD,  HYPERPERIOD,     1000, TASK_CRIT_MEDIUM, TASK_STACKSIZE) \
+  X(a, TelemetryTask,     TELEMETRY_PERIOD, HYPERPERIOD,     5000, TASK_CRIT_LOW,    TASK_STACKSIZE)
+
+/*
+ * X(before, after): 'before' has to run first when both are released at the
+ * same time, i.e. needs the higher priority.
+ */
+#define CRUISE_PRECEDENCE(X)             \
+  X(ControlTask, VehicleTask)            \
+  X(ExtraloadTask, OverloadDetection)
+
+/*
+ * X(task, release offset [ms]): the stages of the control loop in data-flow
+ * order. The inputs are sampled at the start of the period, ControlTask
+ * computes the throttle from them PIPELINE_OFFSET later and VehicleTask
+ * (released together with it, CRUISE_PRECEDENCE) applies it in the same
+ * period, instead of the one after. Tasks not listed are released at
+ * offset 0. host/rta checks that every stage is done before the next
+ * offset and bounds the data age at actuation.
+ *
+ * The cyclic executive (CYCLIC_EXECUTIVE) ignores the offsets, it only
+ * keeps the priority order within a frame.
+ */
+#define PIPELINE_OFFSET 10 /* ms */
+
+#define CRUISE_PIPELINE(X)               \
+  X(ButtonIO,    0)                      \
+  X(SwitchIO,    0)                      \
+  X(ControlTask, PIPELINE_OFFSET)        \
+  X(VehicleTask, PIPELINE_OFFSET)
+
+/* Applies X(entry, period, deadline, budget, criticality, stack) to every task */
+#define TASK_APPLY(X, ...) X(__VA_ARGS__)
+#define CRUISE_TASKS(X) CRUISE_TASK_TABLE(TASK_APPLY, X)
+
+#define TASK_PRIO(name) name##_prio
+
+/*
+ * Deriving the priorities compares every task with every other, i.e. the
+ * table is expanded inside its own expansion. The inner expansion is
+ * deferred until the outer one is done (TASK_DEFER) and then rescanned
+ * (TASK_EXPAND), otherwise the preprocessor would not expand it.
+ */
+#define TASK_EMPTY()
+#define TASK_DEFER(m) m TASK_EMPTY()
+#define TASK_EXPAND(...) __VA_ARGS__
+#define CRUISE_TASK_TABLE_INDIRECT() CRUISE_TASK_TABLE
+
+#define TASK_ID(name, period, deadline, budget, crit, stack) name##_id,
+enum task_id { CRUISE_TASKS(TASK_ID) TASK_COUNT };
+#undef TASK_ID
+
+#define TASK_KEYS(name, period, deadline, budget, crit, stack) \
+  name##_period = (period), name##_deadline = (deadline),
+enum { CRUISE_TASKS(TASK_KEYS) };
+#undef TASK_KEYS
+
+/* 1 if 'name' gets a higher priority than 'self' */
+#define TASK_BEFORE(self, name, period, deadline, budget, crit, stack)                     \
+  + (name##_deadline < self##_deadline                                              \
+     || (name##_deadline == self##_deadline                                         \
+         && (name##_period < self##_period                                          \
+             || (name##_period == self##_period && name##_id < self##_id))))
+#define TASK_DM_PRIO(name, period, deadline, budget, crit, stack) \
+  TASK_PRIO(name) = TASK_PRIO_BASE TASK_DEFER(CRUISE_TASK_TABLE_INDIRECT)()(TASK_BEFORE, name),
+enum task_prio { TASK_EXPAND(CRUISE_TASKS(TASK_DM_PRIO)) };
+#undef TASK_DM_PRIO
+#undef TASK_BEFORE
+
+#define TASK_PRIO_LAST (TASK_PRIO_BASE + TASK_COUNT - 1)
+
+/* Initializer of an array of the release offsets [ms] by task id */
+#define TASK_OFFSET_INIT(name, offset) [name##_id] = (offset),
+#define TASK_OFFSETS { CRUISE_PIPELINE(TASK_OFFSET_INIT) }
+
+/*
+ * Build time checks. Every period divides the hyperperiod and is a multiple
+ * of the SW timer resolution (HRT_TICK_US). The derived priorities are
+ * distinct by construction, so only the fixed priorities can collide with
+ * them.
+ */
+#define TASK_CHECK(name, period, deadline, budget, crit, stack)                          \
+  typedef char name##_period_check[(HYPERPERIOD % (period) == 0                  \
+                                    && (period) * 1000L % HRT_TICK_US == 0) ? 1 : -1]; \
+  typedef char name##_deadline_check[(0 < (deadline) && (deadline) <= (period)) ? 1 : -1];
+CRUISE_TASKS(TASK_CHECK)
+#undef TASK_CHECK
+
+#define TASK_PRECEDENCE_CHECK(before, after) \
+  typedef char before##_before_##after[(TASK_PRIO(before) < TASK_PRIO(after)) ? 1 : -1];
+CRUISE_PRECEDENCE(TASK_PRECEDENCE_CHECK)
+#undef TASK_PRECEDENCE_CHECK
+
+/* an offset keeps the release and deadline of a stage within its period */
+#define TASK_OFFSET_CHECK(name, offset)                                              \
+  typedef char name##_offset_check[((offset) >= 0 && (offset) + name##_deadline <= name##_period \
+                                    && (offset) * 1000L % HRT_TICK_US == 0) ? 1 : -1];
+CRUISE_PIPELINE(TASK_OFFSET_CHECK)
+#undef TASK_OFFSET_CHECK
+
+typedef char starttask_prio_check[(STARTTASK_PRIO < TASK_PRIO_BASE
+                                   || STARTTASK_PRIO > TASK_PRIO_LAST) ? 1 : -1];
+#ifdef OS_LOWEST_PRIO
+/* the two lowest priorities belong to the idle and statistics tasks */
+typedef char lowest_prio_check[(TASK_PRIO_LAST < OS_LOWEST_PRIO - 1) ? 1 : -1];
+#endif
+#ifdef OS_TASK_TMR_PRIO
+typedef char tmr_prio_check[(OS_TASK_TMR_PRIO < TASK_PRIO_BASE
+                             || OS_TASK_TMR_PRIO > TASK_PRIO_LAST) ? 1 : -1];
+#endif
+
+#endif /* CRUISE_TASKS_H */
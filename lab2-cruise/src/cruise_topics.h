@@ -0,0 +1,27 @@
+/* Topics of the cruise control application
+ *
+ * Description:
+ *
+ *   Every signal that is shared between tasks through the topic bus is
+ *   declared here once, with its name and the size of its payload. The list
+ *   is expanded by topic_bus.h into the topic identifiers and by topic_bus.c
+ *   into the static topic table.
+ *
+ *   X(identifier, name, payload size in bytes)
+ */
+#ifndef CRUISE_TOPICS_H
+#define CRUISE_TOPICS_H
+
+#include "cruise_types.h"
+
+#define CRUISE_TOPICS(X)                                       \
+  X(TOPIC_ENGINE,     "engine",     sizeof(enum active))       \
+  X(TOPIC_TOP_GEAR,   "top_gear",   sizeof(enum active))       \
+  X(TOPIC_BRAKE,      "brake",      sizeof(enum active))       \
+  X(TOPIC_GAS_PEDAL,  "gas_pedal",  sizeof(enum active))       \
+  X(TOPIC_CRUISE,     "cruise",     sizeof(enum active))       \
+  X(TOPIC_VELOCITY,   "velocity",   sizeof(INT16S))            \
+  X(TOPIC_POSITION,   "position",   sizeof(INT32U))            \
+  X(TOPIC_TARGET,     "target",     sizeof(INT16S))
+
+#endif /* CRUISE_TOPICS_H */
@@ -0,0 +1,35 @@
+/* Common types for the cruise control application
+ *
+ * Description:
+ *
+ *   The fixed-width integer types used throughout the application come from
+ *   the uC/OS-II port (os_cpu.h). Modules that are also compiled on the host
+ *   (vehicle model, control laws, ...) include this header instead of
+ *   "includes.h" so that they build without the RTOS when CRUISE_HOST is
+ *   defined.
+ */
+#ifndef CRUISE_TYPES_H
+#define CRUISE_TYPES_H
+
+#ifdef CRUISE_HOST
+typedef unsigned char  BOOLEAN;
+typedef unsigned char  INT8U;
+typedef signed   char  INT8S;
+typedef unsigned short INT16U;
+typedef signed   short INT16S;
+typedef unsigned int   INT32U;
+typedef signed   int   INT32S;
+/* the host tools call the portable modules from one thread at a time */
+#define OS_ENTER_CRITICAL()
+#define OS_EXIT_CRITICAL()
+#else
+#include "includes.h"
+#endif
+
+/* not provided by the uC/OS-II port */
+typedef unsigned long long INT64U;
+typedef signed   long long INT64S;
+
+enum active {on = 2, off = 1};
+
+#endif /* CRUISE_TYPES_H */
@@ -0,0 +1,73 @@
+/* Cyclic executive, see cyclic_exec.h */
+#include <stdio.h>
+#include "cyclic_exec.h"
+#include "cruise_clock.h"
+
+INT8U ce_init(cyclic_exec *ce, const ce_task *tasks, INT8U n, INT16U minor_ms, INT16U major_ms)
+{
+  INT8U f, i, j;
+
+  if (n > CE_MAX_TASKS || major_ms % minor_ms != 0 || major_ms / minor_ms > CE_MAX_FRAMES)
+    return CE_ERR_SIZE;
+  for (i = 0; i < n; i++)
+    if (tasks[i].period % minor_ms != 0 || major_ms % tasks[i].period != 0)
+      return CE_ERR_PERIOD;
+
+  ce->tasks = tasks;
+  ce->minor = minor_ms;
+  ce->frames = major_ms / minor_ms;
+  ce->frame = 0;
+  ce->runs = ce->overruns = ce->max_us = 0;
+  ce->max_frame = 0;
+
+  for (f = 0; f < ce->frames; f++) {
+    ce->count[f] = 0;
+    for (i = 0; i < n; i++) {
+      if (f % (tasks[i].period / minor_ms) != 0)
+        continue;
+      /* insertion by priority */
+      for (j = ce->count[f]; j > 0 && tasks[ce->order[f][j - 1]].prio > tasks[i].prio; j--)
+        ce->order[f][j] = ce->order[f][j - 1];
+      ce->order[f][j] = i;
+      ce->count[f]++;
+    }
+  }
+  return 0;
+}
+
+int ce_run_frame(cyclic_exec *ce)
+{
+  INT8U f = ce->frame, i;
+  INT32U start = cruise_clock_us(), t;
+
+  for (i = 0; i < ce->count[f]; i++)
+    ce->tasks[ce->order[f][i]].step();
+
+  t = cruise_clock_us() - start;
+  ce->runs++;
+  if (t > ce->max_us) {
+    ce->max_us = t;
+    ce->max_frame = f;
+  }
+  ce->frame = (f + 1 == ce->frames) ? 0 : f + 1;
+  if (t > ce->minor * 1000UL) {
+    ce->overruns++;
+    return 1;
+  }
+  return 0;
+}
+
+void ce_print_stats(const cyclic_exec *ce)
+{
+  INT8U f, i;
+
+  for (f = 0; f < ce->frames; f++) {
+    printf("frame %u:", f);
+    for (i = 0; i < ce->count[f]; i++)
+      printf(" %s", ce->tasks[ce->order[f][i]].name);
+    printf("\n");
+  }
+  printf("%lu frames, %lu overruns, longest %lu us in frame %u (minor frame %u ms)\n",
+         (unsigned long)ce->runs, (unsigned long)ce->overruns,
+         (unsigned long)ce->max_us, ce->max_frame, ce->minor);
+}
@@ -0,0 +1,53 @@
+/* Cyclic executive
+ *
+ * Description:
+ *
+ *   Time-triggered alternative to one timer and semaphore per task: the
+ *   major cycle (the hyperperiod) is divided into minor frames of equal
+ *   length, and a single periodic interrupt calls ce_run_frame() once per
+ *   frame. Each frame runs, in priority order, the step function of every
+ *   task released at its start; a task with period T is released in every
+ *   (T / minor)-th frame.
+ *
+ *   The frame lists are computed once by ce_init(), so dispatching a frame
+ *   is a walk over a short array. A frame that takes longer than the minor
+ *   frame is an overrun; it is counted and the next frame starts late.
+ */
+#ifndef CYCLIC_EXEC_H
+#define CYCLIC_EXEC_H
+
+#include "cruise_types.h"
+
+#define CE_MAX_FRAMES 32
+#define CE_MAX_TASKS  16
+
+#define CE_ERR_PERIOD 1 /* a period is not a multiple of the minor frame */
+#define CE_ERR_SIZE   2 /* too many tasks or frames */
+
+typedef struct {
+  const char *name;
+  void (*step)(void);
+  INT16U period; /* [ms] */
+  INT8U prio;    /* order within a frame, lower first */
+} ce_task;
+
+typedef struct {
+  const ce_task *tasks;
+  INT16U minor;                              /* [ms] */
+  INT8U frames;                              /* minor frames per major cycle */
+  INT8U frame;                               /* next frame to run */
+  INT8U count[CE_MAX_FRAMES];
+  INT8U order[CE_MAX_FRAMES][CE_MAX_TASKS];  /* tasks of each frame */
+  /* statistics */
+  INT32U runs;
+  INT32U overruns;
+  INT32U max_us;                             /* longest frame */
+  INT8U max_frame;
+} cyclic_exec;
+
+INT8U ce_init(cyclic_exec *ce, const ce_task *tasks, INT8U n, INT16U minor_ms, INT16U major_ms);
+/* Runs the next minor frame; returns 1 if it overran */
+int ce_run_frame(cyclic_exec *ce);
+void ce_print_stats(const cyclic_exec *ce);
+
+#endif /* CYCLIC_EXEC_H */
@@ -0,0 +1,76 @@
+/* Display compositor, see display.h */
+#include <stdio.h>
+#include <string.h>
+#include "display.h"
+
+/* segments of 0..9 and '-', active low */
+static const INT8U digit[] = {0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00, 0x18, 0x3f};
+#define DIGIT_MINUS 10
+
+static INT32U seg_words[DISP_MAX - DISP_MIN + 1];
+
+static INT32U value[DISP_REGS];   /* composed content */
+static INT32U shown[DISP_REGS];   /* last written content */
+static INT8U written;             /* 'shown' is valid */
+static INT32U writes, saved;
+
+void disp_init(void)
+{
+  int v, a;
+
+  for (v = DISP_MIN; v <= DISP_MAX; v++) {
+    a = v < 0 ? -v : v;
+    seg_words[v - DISP_MIN] = (INT32U)digit[0] << 21
+                            | (INT32U)digit[v < 0 ? DIGIT_MINUS : 0] << 14
+                            | (INT32U)digit[a / 10] << 7
+                            | digit[a % 10];
+  }
+  memset(value, 0, sizeof(value));
+  value[DISP_HEX_LOW] = value[DISP_HEX_HIGH] = disp_seg_word(0);
+  written = 0;
+  writes = saved = 0;
+}
+
+void disp_set_bits(enum disp_reg reg, INT32U mask, INT32U bits)
+{
+  value[reg] = (value[reg] & ~mask) | (bits & mask);
+}
+
+INT32U disp_seg_word(INT16S v)
+{
+  if (v < DISP_MIN)
+    v = DISP_MIN;
+  if (v > DISP_MAX)
+    v = DISP_MAX;
+  return seg_words[v - DISP_MIN];
+}
+
+void disp_set_number(enum disp_reg reg, INT16S v)
+{
+  value[reg] = disp_seg_word(v);
+}
+
+INT8U disp_flush(disp_write_fn write)
+{
+  INT8U n = 0;
+  int i;
+
+  for (i = 0; i < DISP_REGS; i++) {
+    if (written && value[i] == shown[i]) {
+      saved++;
+      continue;
+    }
+    write((enum disp_reg)i, value[i]);
+    shown[i] = value[i];
+    n++;
+  }
+  written = 1;
+  writes += n;
+  return n;
+}
+
+void disp_print_stats(void)
+{
+  printf("display: %lu writes, %lu saved (%lu%%)\n", (unsigned long)writes, (unsigned long)saved,
+         (unsigned long)(writes + saved ? (INT64U)saved * 100 / (writes + saved) : 0));
+}
@@ -0,0 +1,46 @@
+/* Display compositor
+ *
+ * Description:
+ *
+ *   Owns every output of the board that is only there to be looked at: the
+ *   green and red LEDs and the two banks of four seven-segment digits.
+ *   Tasks do not write these registers; DisplayTask collects what they
+ *   published, sets it here, and disp_flush() writes the registers whose
+ *   content changed since the last write. The first flush writes all.
+ *
+ *   The LEDs of a register are shared between sources, each source sets
+ *   only the bits of its mask with disp_set_bits(). A number is shown as
+ *   "0", sign, tens, ones on a bank of digits; the 28-bit words for
+ *   -99..99 are computed once by disp_init(), values beyond are clamped.
+ *
+ *   The registers are written through the function given to disp_flush(),
+ *   so the module also runs on the host.
+ */
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "cruise_types.h"
+
+#define DISP_MIN -99
+#define DISP_MAX 99
+
+enum disp_reg {
+  DISP_GREEN,     /* green LEDs */
+  DISP_RED,       /* red LEDs */
+  DISP_HEX_LOW,   /* HEX3..HEX0: velocity */
+  DISP_HEX_HIGH,  /* HEX7..HEX4: target velocity */
+  DISP_REGS
+};
+
+typedef void (*disp_write_fn)(enum disp_reg reg, INT32U value);
+
+void disp_init(void);
+void disp_set_bits(enum disp_reg reg, INT32U mask, INT32U bits);
+void disp_set_number(enum disp_reg reg, INT16S value);
+/* 28-bit seven-segment word of 'value' */
+INT32U disp_seg_word(INT16S value);
+/* Writes the changed registers, returns how many */
+INT8U disp_flush(disp_write_fn write);
+void disp_print_stats(void);
+
+#endif /* DISPLAY_H */
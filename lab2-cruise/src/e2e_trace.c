@@ -0,0 +1,108 @@
+/* End-to-end latency tracing, see e2e_trace.h */
+#include <stdio.h>
+#include <string.h>
+#include "e2e_trace.h"
+#include "cruise_clock.h"
+
+#define TRACE_NAME(id, name) name,
+static const char *const names[TRACE_CHAINS] = { CRUISE_CHAINS(TRACE_NAME) };
+#undef TRACE_NAME
+
+static trace_stats stats[TRACE_CHAINS];
+static INT32U last_id[TRACE_CHAINS]; /* newest sample seen at the sink */
+static INT32U samples;
+
+void trace_init(void)
+{
+  int i;
+
+  memset(stats, 0, sizeof(stats));
+  memset(last_id, 0, sizeof(last_id));
+  for (i = 0; i < TRACE_CHAINS; i++)
+    stats[i].age_min = stats[i].react_min = 0xffffffff;
+  samples = 0;
+}
+
+void trace_sample(trace_tag *tag)
+{
+  INT32U now = cruise_clock_us();
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  if (++samples == 0)
+    samples = 1;
+  tag->id = samples;
+  OS_EXIT_CRITICAL();
+  tag->origin = now;
+}
+
+void trace_merge(trace_tag *into, const trace_tag *tag)
+{
+  if (tag->id != 0 && (into->id == 0 || (INT32S)(tag->origin - into->origin) > 0))
+    *into = *tag;
+}
+
+void trace_sink(INT8U chain, const trace_tag *tag)
+{
+  trace_stats *s = &stats[chain];
+  INT32U age;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  if (tag->id == 0)
+    return;
+  age = cruise_clock_us() - tag->origin;
+  OS_ENTER_CRITICAL();
+  s->updates++;
+  s->age_sum += age;
+  if (age < s->age_min)
+    s->age_min = age;
+  if (age > s->age_max)
+    s->age_max = age;
+  if (tag->id != last_id[chain]) {
+    last_id[chain] = tag->id;
+    s->reactions++;
+    s->react_sum += age;
+    if (age < s->react_min)
+      s->react_min = age;
+    if (age > s->react_max)
+      s->react_max = age;
+  }
+  OS_EXIT_CRITICAL();
+}
+
+void trace_get(INT8U chain, trace_stats *out)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  *out = stats[chain];
+  OS_EXIT_CRITICAL();
+  if (out->updates == 0)
+    out->age_min = 0;
+  if (out->reactions == 0)
+    out->react_min = 0;
+}
+
+void trace_print(void)
+{
+  trace_stats s;
+  int i;
+
+  printf("%-16s %7s %8s %8s %8s %7s %8s %8s %8s\n", "chain [us]", "updates", "age_min",
+         "age_avg", "age_max", "react", "rea_min", "rea_avg", "rea_max");
+  for (i = 0; i < TRACE_CHAINS; i++) {
+    trace_get(i, &s);
+    printf("%-16s %7lu %8lu %8lu %8lu %7lu %8lu %8lu %8lu\n", names[i],
+           (unsigned long)s.updates, (unsigned long)s.age_min,
+           (unsigned long)(s.updates ? s.age_sum / s.updates : 0), (unsigned long)s.age_max,
+           (unsigned long)s.reactions, (unsigned long)s.react_min,
+           (unsigned long)(s.reactions ? s.react_sum / s.reactions : 0),
+           (unsigned long)s.react_max);
+  }
+}
@@ -0,0 +1,69 @@
+/* End-to-end latency tracing
+ *
+ * Description:
+ *
+ *   Every input sample gets a tag with a sample number and the time it was
+ *   sampled (trace_sample()). The tag travels with the data: in the
+ *   payload of a mailbox (trace_msg) or next to the sample of a topic
+ *   (topic_publish_traced()). A task that combines several inputs passes
+ *   on the tag of the newest input sample (trace_merge()).
+ *
+ *   Where a chain ends in an output, trace_sink() is called with the tag of
+ *   the data the output was computed from, every time the output is
+ *   updated. Per chain it records
+ *
+ *     data age       now - sample time, for every update,
+ *     reaction time  now - sample time, for the first update based on a
+ *                    new sample, i.e. the first reaction to an input.
+ *
+ *   The chains are declared in CRUISE_CHAINS, X(identifier, name).
+ */
+#ifndef E2E_TRACE_H
+#define E2E_TRACE_H
+
+#include "cruise_types.h"
+
+#define CRUISE_CHAINS(X)                                                    \
+  X(CHAIN_BUTTON_LEDS, "button->leds")      /* ButtonIO, DisplayTask */      \
+  X(CHAIN_SWITCH_LEDS, "switch->leds")      /* SwitchIO, DisplayTask */      \
+  X(CHAIN_ACTUATION,   "input->throttle")   /* ButtonIO/SwitchIO, ControlTask, VehicleTask */ \
+  X(CHAIN_TARGET,      "input->target")     /* ..., ControlTask, DisplayTask */ \
+  X(CHAIN_VELOCITY,    "input->velocity")   /* ..., VehicleTask, DisplayTask */
+
+#define TRACE_ENUM(id, name) id,
+enum trace_chain {
+  CRUISE_CHAINS(TRACE_ENUM)
+  TRACE_CHAINS
+};
+#undef TRACE_ENUM
+
+typedef struct {
+  INT32U id;      /* sample number, 0: untraced */
+  INT32U origin;  /* sample time [us] */
+} trace_tag;
+
+/* Mailbox payload of one value with the tag of its data */
+typedef struct {
+  INT32S value;
+  trace_tag tag;
+} trace_msg;
+
+typedef struct {
+  INT32U updates;
+  INT32U age_min;       /* [us] */
+  INT32U age_max;
+  INT64U age_sum;       /* 32 bit would wrap within hours */
+  INT32U reactions;
+  INT32U react_min;     /* [us] */
+  INT32U react_max;
+  INT64U react_sum;
+} trace_stats;
+
+void trace_init(void);
+void trace_sample(trace_tag *tag);
+void trace_merge(trace_tag *into, const trace_tag *tag);
+void trace_sink(INT8U chain, const trace_tag *tag);
+void trace_get(INT8U chain, trace_stats *stats);
+void trace_print(void);
+
+#endif /* E2E_TRACE_H */
@@ -0,0 +1,23 @@
+/* Gain schedule lookup, see gain_table.h */
+#include "gain_table.h"
+
+/*
+ * Value of the schedule at 'x' (Q15.16) in Q8. Between two entries the
+ * value is interpolated with the upper 8 bits of the fraction of 'x'.
+ */
+INT32S gs_lookup(const gain_table *t, INT32S x)
+{
+  INT32S i, frac, lo, hi;
+
+  x -= (INT32S)t->x_min * 65536; /* x_min may be negative, no shift */
+  if (x <= 0)
+    return t->y[0];
+  i = x >> 16;
+  if (i >= t->size - 1)
+    return t->y[t->size - 1];
+
+  frac = (x >> 8) & 0xff;
+  lo = t->y[i];
+  hi = t->y[i + 1];
+  return lo + (((hi - lo) * frac + 0x80) >> 8);
+}
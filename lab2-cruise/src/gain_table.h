@@ -0,0 +1,107 @@
+/* Gain schedules expanded into dense lookup tables at compile time
+ *
+ * Description:
+ *
+ *   A gain schedule is a piecewise linear function given by up to
+ *   GS_MAX_POINTS breakpoints (x, y) with strictly increasing integer x.
+ *   Instead of searching the breakpoints at run time, the function is
+ *   evaluated by the preprocessor/compiler at every integer x from the first
+ *   breakpoint on and stored as a dense table of Q8 values. A lookup is then
+ *   a subtraction, a clamp and one interpolation between two neighbouring
+ *   entries, independent of the number of breakpoints.
+ *
+ *   Declaring a schedule (breakpoints are integer constant expressions):
+ *
+ *     #define SPEED_X(i) GS_PICK(i, -5, 10, 20, 30)
+ *     #define SPEED_Y(i) GS_PICK(i, 30, 30, 40, 50)
+ *     #define SPEED_ENTRY(k) GS_ENTRY(k, SPEED_X, SPEED_Y),
+ *
+ *     static const INT16S speed_y[] = { GS_REP64(SPEED_ENTRY, 0) };
+ *     const gain_table speed = GS_TABLE(SPEED_X, speed_y);
+ *
+ *   GS_ENTRY(k, X, Y) is the value at x = X(0) + k; entries beyond the last
+ *   breakpoint (x = 30 above) repeat its value, so the table just has to be
+ *   chosen large enough (GS_REP32/64/128/256) to cover the range. Inputs
+ *   outside the table saturate at the first or last entry.
+ */
+#ifndef GAIN_TABLE_H
+#define GAIN_TABLE_H
+
+#include "cruise_types.h"
+
+#define GS_FRAC_BITS  8
+#define GS_ONE        (1 << GS_FRAC_BITS)
+#define GS_MAX_POINTS 16
+#define GS_END        0x7fff /* pads unused breakpoints */
+
+typedef struct {
+  INT16S        x_min; /* x of the first entry */
+  INT16U        size;  /* number of entries */
+  const INT16S *y;     /* Q8 values at x_min, x_min + 1, ... */
+} gain_table;
+
+/*
+ * GS_PICK(i, a0, a1, ...) is a_i. The index has to be a literal 0..15, the
+ * selection is then done by the preprocessor and costs nothing to compile.
+ */
+#define GS_PICK(i, ...) GS_PICK_(i, __VA_ARGS__, GS_END, GS_END, GS_END, GS_END, \
+    GS_END, GS_END, GS_END, GS_END, GS_END, GS_END, GS_END, GS_END, GS_END, GS_END, GS_END)
+#define GS_PICK_(i, ...) GS_ARG ## i(__VA_ARGS__)
+#define GS_ARG0(a0, ...) (a0)
+#define GS_ARG1(a0, a1, ...) (a1)
+#define GS_ARG2(a0, a1, a2, ...) (a2)
+#define GS_ARG3(a0, a1, a2, a3, ...) (a3)
+#define GS_ARG4(a0, a1, a2, a3, a4, ...) (a4)
+#define GS_ARG5(a0, a1, a2, a3, a4, a5, ...) (a5)
+#define GS_ARG6(a0, a1, a2, a3, a4, a5, a6, ...) (a6)
+#define GS_ARG7(a0, a1, a2, a3, a4, a5, a6, a7, ...) (a7)
+#define GS_ARG8(a0, a1, a2, a3, a4, a5, a6, a7, a8, ...) (a8)
+#define GS_ARG9(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, ...) (a9)
+#define GS_ARG10(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, ...) (a10)
+#define GS_ARG11(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, ...) (a11)
+#define GS_ARG12(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, ...) (a12)
+#define GS_ARG13(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, ...) (a13)
+#define GS_ARG14(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, ...) (a14)
+#define GS_ARG15(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, ...) (a15)
+
+#define GS_DIV_ROUND(n, d) ((n) >= 0 ? ((n) + (d) / 2) / (d) : ((n) - (d) / 2) / (d))
+
+/*
+ * Contribution of segment [X(i), X(j)), j = i + 1: the interpolated
+ * value inside the segment, the value of X(i) if it is the last breakpoint
+ * and x lies at or beyond it, 0 otherwise. Unused breakpoints are GS_END, so
+ * at most one segment contributes for any x >= X(0).
+ */
+#define GS_SEG(x, X, Y, i, j)                                                   \
+  (X(j) != GS_END                                                               \
+   ? (X(i) <= (x) && (x) < X(j)                                                 \
+      ? Y(i) * GS_ONE + GS_DIV_ROUND((Y(j) - Y(i)) * GS_ONE * ((x) - X(i)),    \
+                                     X(j) - X(i))                               \
+      : 0)                                                                      \
+   : (X(i) != GS_END && X(i) <= (x) ? Y(i) * GS_ONE : 0))
+
+/* Q8 value of the schedule at x >= X(0) */
+#define GS_VALUE(x, X, Y)                                                       \
+  (GS_SEG(x, X, Y, 0, 1) + GS_SEG(x, X, Y, 1, 2) + GS_SEG(x, X, Y, 2, 3) + \
+   GS_SEG(x, X, Y, 3, 4) + GS_SEG(x, X, Y, 4, 5) + GS_SEG(x, X, Y, 5, 6) + \
+   GS_SEG(x, X, Y, 6, 7) + GS_SEG(x, X, Y, 7, 8) + GS_SEG(x, X, Y, 8, 9) + \
+   GS_SEG(x, X, Y, 9, 10) + GS_SEG(x, X, Y, 10, 11) + GS_SEG(x, X, Y, 11, 12) + \
+   GS_SEG(x, X, Y, 12, 13) + GS_SEG(x, X, Y, 13, 14) + GS_SEG(x, X, Y, 14, 15) + \
+   (X(15) != GS_END && X(15) <= (x) ? Y(15) * GS_ONE : 0))
+
+/* Q8 value of the k:th dense entry */
+#define GS_ENTRY(k, X, Y) GS_VALUE(X(0) + (k), X, Y)
+
+#define GS_TABLE(X, y) { X(0), sizeof(y) / sizeof((y)[0]), (y) }
+
+/* M(base), M(base + 1), ... */
+#define GS_REP4(M, b)   M(b) M((b) + 1) M((b) + 2) M((b) + 3)
+#define GS_REP16(M, b)  GS_REP4(M, b) GS_REP4(M, (b) + 4) GS_REP4(M, (b) + 8) GS_REP4(M, (b) + 12)
+#define GS_REP32(M, b)  GS_REP16(M, b) GS_REP16(M, (b) + 16)
+#define GS_REP64(M, b)  GS_REP32(M, b) GS_REP32(M, (b) + 32)
+#define GS_REP128(M, b) GS_REP64(M, b) GS_REP64(M, (b) + 64)
+#define GS_REP256(M, b) GS_REP128(M, b) GS_REP128(M, (b) + 128)
+
+INT32S gs_lookup(const gain_table *t, INT32S x);
+
+#endif /* GAIN_TABLE_H */
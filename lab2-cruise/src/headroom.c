@@ -0,0 +1,75 @@
+/* Overload headroom search, see headroom.h */
+#include <stdio.h>
+#include "headroom.h"
+
+static void start_trial(headroom *h)
+{
+  h->lo = 0;
+  h->hi = 1001; /* 1000 per mille may still be sustainable */
+}
+
+void headroom_init(headroom *h, INT16U resolution, INT8U trials)
+{
+  h->resolution = resolution ? resolution : 1;
+  h->trials = trials > HEADROOM_MAX_TRIALS ? HEADROOM_MAX_TRIALS : trials;
+  h->trial = 0;
+  start_trial(h);
+}
+
+INT16U headroom_probe(const headroom *h)
+{
+  return (h->lo + h->hi) / 2;
+}
+
+void headroom_report(headroom *h, int missed)
+{
+  INT16U probe = headroom_probe(h);
+
+  if (headroom_done(h))
+    return;
+  if (missed)
+    h->hi = probe;
+  else
+    h->lo = probe;
+  if (h->hi - h->lo <= h->resolution) {
+    h->result[h->trial++] = h->lo;
+    start_trial(h);
+  }
+}
+
+int headroom_done(const headroom *h)
+{
+  return h->trial >= h->trials;
+}
+
+void headroom_result(const headroom *h, INT16U *min, INT16U *avg, INT16U *max)
+{
+  INT32U sum = 0;
+  int i;
+
+  *min = 0xffff;
+  *max = 0;
+  for (i = 0; i < h->trial; i++) {
+    sum += h->result[i];
+    if (h->result[i] < *min)
+      *min = h->result[i];
+    if (h->result[i] > *max)
+      *max = h->result[i];
+  }
+  if (h->trial == 0)
+    *min = 0;
+  *avg = h->trial ? (INT16U)(sum / h->trial) : 0;
+}
+
+void headroom_print(const headroom *h)
+{
+  INT16U min, avg, max;
+  int i;
+
+  headroom_result(h, &min, &avg, &max);
+  printf("headroom [per mille]:");
+  for (i = 0; i < h->trial; i++)
+    printf(" %u", h->result[i]);
+  printf("\nheadroom: min %u.%u %%, avg %u.%u %%, max %u.%u %% extra utilization\n",
+         min / 10, min % 10, avg / 10, avg % 10, max / 10, max % 10);
+}
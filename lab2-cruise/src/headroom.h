@@ -0,0 +1,40 @@
+/* Overload headroom search
+ *
+ * Description:
+ *
+ *   Finds the largest extra load (per mille of a period) that still meets
+ *   every deadline, by binary search between 0 and 1000: the caller runs
+ *   the system with headroom_probe() extra load, reports with
+ *   headroom_report() whether a deadline was missed, and repeats until
+ *   headroom_done(). The search is repeated 'trials' times, the spread of
+ *   the results shows how repeatable the breaking point is.
+ *
+ *   The search itself does not depend on the RTOS; WatchdogTask drives it
+ *   on the board (HEADROOM_TEST) and host/headroom_sim.c drives it with a
+ *   simulated scheduler.
+ */
+#ifndef HEADROOM_H
+#define HEADROOM_H
+
+#include "cruise_types.h"
+
+#define HEADROOM_MAX_TRIALS 16
+
+typedef struct {
+  INT16U lo;          /* highest load without a miss so far [per mille] */
+  INT16U hi;          /* lowest load with a miss so far */
+  INT16U resolution;  /* stop when hi - lo <= resolution */
+  INT8U trials;
+  INT8U trial;        /* current trial */
+  INT16U result[HEADROOM_MAX_TRIALS];
+} headroom;
+
+void headroom_init(headroom *h, INT16U resolution, INT8U trials);
+INT16U headroom_probe(const headroom *h);
+void headroom_report(headroom *h, int missed);
+int headroom_done(const headroom *h);
+/* Smallest, average and largest result of the finished trials */
+void headroom_result(const headroom *h, INT16U *min, INT16U *avg, INT16U *max);
+void headroom_print(const headroom *h);
+
+#endif /* HEADROOM_H */
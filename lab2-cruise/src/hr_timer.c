@@ -0,0 +1,146 @@
+/* High-resolution software timers, see hr_timer.h */
+#include <stddef.h>
+#include "hr_timer.h"
+
+typedef char hrt_wheel_size_check[(HRT_WHEEL_SIZE & (HRT_WHEEL_SIZE - 1)) == 0 ? 1 : -1];
+
+static hrt_timer *wheel[HRT_WHEEL_SIZE];
+static volatile INT32U now;
+
+/* Links 't' into the slot of t->expires; called with interrupts disabled */
+static void link_timer(hrt_timer *t)
+{
+  hrt_timer **slot = &wheel[t->expires & (HRT_WHEEL_SIZE - 1)];
+
+  t->next = *slot;
+  if (t->next)
+    t->next->pprev = &t->next;
+  t->pprev = slot;
+  *slot = t;
+}
+
+static void unlink_timer(hrt_timer *t)
+{
+  *t->pprev = t->next;
+  if (t->next)
+    t->next->pprev = t->pprev;
+  t->pprev = NULL;
+}
+
+void hrt_init(void)
+{
+  int i;
+
+  for (i = 0; i < HRT_WHEEL_SIZE; i++)
+    wheel[i] = NULL;
+  now = 0;
+}
+
+void hrt_timer_init(hrt_timer *t, void (*callback)(void *arg), void *arg)
+{
+  t->next = NULL;
+  t->pprev = NULL;
+  t->callback = callback;
+  t->arg = arg;
+}
+
+void hrt_start(hrt_timer *t, INT32U base, INT32U phase_us, INT32U period_us)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  if (t->pprev)
+    unlink_timer(t);
+  t->period = HRT_US_TO_TICKS(period_us);
+  t->expires = base + HRT_US_TO_TICKS(phase_us);
+  /* a first expiry that already passed is moved to the next tick, or to
+   * the next one in phase for a periodic timer */
+  while ((INT32S)(t->expires - now) <= 0) {
+    if (t->period == 0) {
+      t->expires = now + 1;
+      break;
+    }
+    t->expires += t->period;
+  }
+  link_timer(t);
+  OS_EXIT_CRITICAL();
+}
+
+void hrt_stop(hrt_timer *t)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  if (t->pprev)
+    unlink_timer(t);
+  OS_EXIT_CRITICAL();
+}
+
+/*
+ * Changes the period of a running periodic timer in phase: the next expiry
+ * is the last one plus the new period, or the next tick if that passed.
+ */
+void hrt_set_period(hrt_timer *t, INT32U period_us)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+  INT32U last;
+
+  OS_ENTER_CRITICAL();
+  if (t->pprev && t->period) {
+    last = t->expires - t->period;
+    unlink_timer(t);
+    t->period = HRT_US_TO_TICKS(period_us);
+    t->expires = last + t->period;
+    if ((INT32S)(t->expires - now) <= 0)
+      t->expires = now + 1;
+    link_timer(t);
+  }
+  OS_EXIT_CRITICAL();
+}
+
+INT32U hrt_now(void)
+{
+  return now;
+}
+
+/*
+ * Advances the time by one tick and runs the callbacks of the timers that
+ * expire. Timers of later rounds of the wheel stay in the slot.
+ */
+void hrt_tick(void)
+{
+  hrt_timer *t, *next, *expired = NULL;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  now++;
+  for (t = wheel[now & (HRT_WHEEL_SIZE - 1)]; t != NULL; t = next) {
+    next = t->next;
+    if (t->expires == now) {
+      unlink_timer(t);
+      t->next = expired;
+      expired = t;
+    }
+  }
+  OS_EXIT_CRITICAL();
+
+  /* callbacks may restart or stop timers, so the slot is not walked here */
+  for (t = expired; t != NULL; t = next) {
+    next = t->next;
+    if (t->period) {
+      t->expires += t->period;
+      OS_ENTER_CRITICAL();
+      link_timer(t);
+      OS_EXIT_CRITICAL();
+    }
+    t->callback(t->arg);
+  }
+}
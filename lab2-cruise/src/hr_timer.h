@@ -0,0 +1,49 @@
+/* High-resolution software timers
+ *
+ * Description:
+ *
+ *   One-shot and periodic timers with a resolution of HRT_TICK_US, driven
+ *   by a single periodic interrupt that calls hrt_tick(). The timers are
+ *   kept in a hashed timing wheel of HRT_WHEEL_SIZE slots: a timer expiring
+ *   at tick n is linked into slot n % HRT_WHEEL_SIZE, so a tick only looks
+ *   at the timers of one slot instead of all of them, and starting or
+ *   stopping a timer is O(1).
+ *
+ *   Callbacks run in the context of hrt_tick(), i.e. in the interrupt, and
+ *   may only use ISR-safe calls such as OSSemPost().
+ *
+ *   Timers started with the same 'base' (a value of hrt_now()) share the
+ *   same phase reference; 'phase_us' shifts the first expiry against it.
+ */
+#ifndef HR_TIMER_H
+#define HR_TIMER_H
+
+#include "cruise_types.h"
+
+#ifndef HRT_TICK_US
+#define HRT_TICK_US 1000 /* resolution [us] */
+#endif
+#define HRT_WHEEL_SIZE 64 /* power of two */
+
+#define HRT_US_TO_TICKS(us) (((us) + HRT_TICK_US - 1) / HRT_TICK_US)
+
+typedef struct hrt_timer {
+  struct hrt_timer *next;
+  struct hrt_timer **pprev;   /* link pointing to this timer, NULL if stopped */
+  INT32U expires;             /* [ticks] */
+  INT32U period;              /* [ticks], 0 for a one-shot timer */
+  void (*callback)(void *arg);
+  void *arg;
+} hrt_timer;
+
+void hrt_init(void);
+void hrt_timer_init(hrt_timer *t, void (*callback)(void *arg), void *arg);
+/* Expires at base + phase_us, then every period_us (0 = only once) */
+void hrt_start(hrt_timer *t, INT32U base, INT32U phase_us, INT32U period_us);
+void hrt_stop(hrt_timer *t);
+/* New period of a running periodic timer, counted from its last expiry */
+void hrt_set_period(hrt_timer *t, INT32U period_us);
+INT32U hrt_now(void);
+void hrt_tick(void);
+
+#endif /* HR_TIMER_H */
@@ -0,0 +1,97 @@
+/* Input replay, see input_replay.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include "input_replay.h"
+
+static const replay_event *events;
+static INT16U count;
+
+void replay_init(const replay_event *script, INT16U n)
+{
+  events = script;
+  count = n;
+}
+
+const replay_event *replay_at(INT32U ms)
+{
+  INT16U lo = 0, hi = count, mid;
+
+  /* first state after 'ms' */
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (events[mid].time <= ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo ? &events[lo - 1] : NULL;
+}
+
+INT8U replay_keys(INT32U ms)
+{
+  const replay_event *ev = replay_at(ms);
+
+  return ev ? ev->keys : 0;
+}
+
+INT32U replay_switches(INT32U ms)
+{
+  const replay_event *ev = replay_at(ms);
+
+  return ev ? ev->switches : 0;
+}
+
+INT32U replay_length(void)
+{
+  return count ? events[count - 1].time : 0;
+}
+
+int replay_parse(const char *line, replay_event *ev)
+{
+  unsigned long t;
+  long k, s;
+  char rest[2];
+  int n;
+
+  while (*line == ' ' || *line == '\t')
+    line++;
+  if (*line == '#' || *line == '\n' || *line == '\r' || *line == '\0')
+    return 0;
+  n = sscanf(line, "%lu %li %li %1s", &t, &k, &s, rest);
+  if (n < 3 || (n == 4 && rest[0] != '#') || k < 0 || k > 0xf || s < 0 || s > 0x3ffff)
+    return -1;
+  ev->time = t;
+  ev->keys = (INT8U)k;
+  ev->switches = s;
+  return 1;
+}
+
+#ifdef CRUISE_HOST
+int replay_load(const char *path, replay_event *ev, int max)
+{
+  FILE *f = fopen(path, "r");
+  char line[256];
+  int n = 0, lineno = 0, r;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    if (n == max) {
+      fprintf(stderr, "%s:%d: more than %d states\n", path, lineno, max);
+      break;
+    }
+    r = replay_parse(line, &ev[n]);
+    if (r < 0 || (r > 0 && n > 0 && ev[n].time < ev[n - 1].time)) {
+      fprintf(stderr, "%s:%d: %s\n", path, lineno, r < 0 ? "syntax error" : "time goes backwards");
+      break;
+    }
+    n += r;
+  }
+  r = feof(f) ? n : -1;
+  fclose(f);
+  return r;
+}
+#endif
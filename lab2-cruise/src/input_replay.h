@@ -0,0 +1,48 @@
+/* Input replay
+ *
+ * Description:
+ *
+ *   A replay script is a list of input states sorted by time:
+ *
+ *     <time ms> <keys> <switches>
+ *
+ *   'keys' has a bit set for every push button held down (KEY0 = bit 0),
+ *   'switches' is the value of the 18 toggle switches. A state holds from
+ *   its time until the next one. '#' starts a comment, numbers may be
+ *   decimal or 0x hex.
+ *
+ *   With INPUT_REPLAY the tasks of cruise_skeleton.c read their inputs from
+ *   the script instead of the PIOs, at the logical time of their release
+ *   (releases so far times the period), so a run does not depend on when
+ *   exactly a task gets the CPU and produces the same outputs every time.
+ *   On the board the script is the table of replay_script.h, generated
+ *   from a script file by host/replay_gen; host/replay runs a script file
+ *   through the closed loop directly.
+ */
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include "cruise_types.h"
+
+typedef struct {
+  INT32U time;      /* [ms] */
+  INT8U  keys;      /* pressed = 1 */
+  INT32U switches;
+} replay_event;
+
+void replay_init(const replay_event *script, INT16U n);
+/* The state at 'ms', NULL before the first one */
+const replay_event *replay_at(INT32U ms);
+INT8U  replay_keys(INT32U ms);
+INT32U replay_switches(INT32U ms);
+/* Time of the last state [ms] */
+INT32U replay_length(void);
+
+/* Parses one line: 1 for a state, 0 for a blank line or comment, -1 on error */
+int replay_parse(const char *line, replay_event *ev);
+#ifdef CRUISE_HOST
+/* Reads a script file, returns the number of states or -1 */
+int replay_load(const char *path, replay_event *events, int max);
+#endif
+
+#endif /* INPUT_REPLAY_H */
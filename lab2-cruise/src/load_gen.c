@@ -0,0 +1,92 @@
+/* Calibrated synthetic load, see load_gen.h */
+#include "load_gen.h"
+#include "cruise_clock.h"
+
+#define LOAD_CALIBRATION_US 20000 /* length of the calibration */
+#define LOAD_ROUNDS 5
+#define LOAD_CHUNK 1000           /* iterations between two clock reads */
+
+static INT32U loops_per_ms = 1;
+
+/* noinline and volatile keep the compiler from shortening the loop */
+static void __attribute__((noinline)) spin(INT32U n)
+{
+  volatile INT32U i;
+
+  for (i = 0; i < n; i++)
+    ;
+}
+
+/*
+ * The calibration is split into rounds and the fastest one is taken: an
+ * interrupt can only make a round slower, never faster.
+ */
+INT32U load_calibrate(void)
+{
+  INT32U start, t, loops, rate, best = 0;
+  int round;
+
+  spin(LOAD_CHUNK); /* warm up the caches */
+  for (round = 0; round < LOAD_ROUNDS; round++) {
+    loops = 0;
+    start = cruise_clock_us();
+    do {
+      spin(LOAD_CHUNK);
+      loops += LOAD_CHUNK;
+      t = cruise_clock_us() - start;
+    } while (t < LOAD_CALIBRATION_US / LOAD_ROUNDS);
+    rate = (INT32U)((INT64U)loops * 1000 / t);
+    if (rate > best)
+      best = rate;
+  }
+
+  loops_per_ms = best ? best : 1;
+  return loops_per_ms;
+}
+
+void load_burn_us(INT32U us)
+{
+  /* whole milliseconds first, so the product cannot overflow */
+  INT32U ms = us / 1000;
+
+  while (ms--)
+    spin(loops_per_ms);
+  spin((INT32U)((INT64U)(us % 1000) * loops_per_ms / 1000));
+}
+
+void load_gen_init(load_gen *g, enum load_mode mode, INT16U base, INT16U amplitude,
+                   INT32U length, INT32U seed)
+{
+  g->mode = mode;
+  g->base = base;
+  g->amplitude = amplitude;
+  g->length = length ? length : 1;
+  g->seed = seed;
+  g->release = 0;
+  g->state = seed;
+}
+
+INT16U load_gen_next(load_gen *g, INT8U switches)
+{
+  INT32U l = 0, r = g->release++;
+
+  switch (g->mode) {
+    case LOAD_SWITCHES:
+      l = (INT32U)switches * 10;
+      break;
+    case LOAD_CONST:
+      l = g->base;
+      break;
+    case LOAD_STEP:
+      l = g->base + (r >= g->length ? g->amplitude : 0);
+      break;
+    case LOAD_RAMP:
+      l = g->base + (INT32U)g->amplitude * (r % g->length) / g->length;
+      break;
+    case LOAD_RANDOM:
+      g->state = g->state * 1664525 + 1013904223; /* Numerical Recipes LCG */
+      l = g->base + (INT32U)(((INT64U)(g->state >> 8) * (g->amplitude + 1)) >> 24);
+      break;
+  }
+  return (INT16U)(l > 1000 ? 1000 : l);
+}
@@ -0,0 +1,50 @@
+/* Calibrated synthetic load
+ *
+ * Description:
+ *
+ *   load_calibrate() measures once at boot how many iterations of the busy
+ *   loop fit into a millisecond, against the performance counter. After
+ *   that load_burn_us() burns a given number of microseconds of CPU time
+ *   with a loop of known length, i.e. deterministic and independent of
+ *   preemption (a preempted burn finishes later, but takes the same CPU
+ *   time).
+ *
+ *   A load_gen decides how much to burn in each release of the load task:
+ *
+ *     LOAD_SWITCHES  the switch value (0..63) in percent of the period
+ *     LOAD_CONST     'base'
+ *     LOAD_STEP      'base', and 'base' + 'amplitude' from release 'length' on
+ *     LOAD_RAMP      from 'base' up by 'amplitude' over 'length' releases,
+ *                    then again from 'base'
+ *     LOAD_RANDOM    uniform in 'base' .. 'base' + 'amplitude', from a
+ *                    seeded generator, so a run can be repeated exactly
+ *
+ *   Loads are in per mille of the period of the load task.
+ */
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include "cruise_types.h"
+
+enum load_mode {LOAD_SWITCHES, LOAD_CONST, LOAD_STEP, LOAD_RAMP, LOAD_RANDOM};
+
+typedef struct {
+  enum load_mode mode;
+  INT16U base;       /* per mille */
+  INT16U amplitude;  /* per mille */
+  INT32U length;     /* releases */
+  INT32U seed;
+  INT32U release;    /* releases so far */
+  INT32U state;      /* random generator */
+} load_gen;
+
+/* Returns the measured loop iterations per ms */
+INT32U load_calibrate(void);
+void load_burn_us(INT32U us);
+
+void load_gen_init(load_gen *g, enum load_mode mode, INT16U base, INT16U amplitude,
+                   INT32U length, INT32U seed);
+/* Load of the next release [per mille]; 'switches' is only used by LOAD_SWITCHES */
+INT16U load_gen_next(load_gen *g, INT8U switches);
+
+#endif /* LOAD_GEN_H */
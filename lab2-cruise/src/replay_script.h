@@ -0,0 +1,28 @@
+/* Replay script for INPUT_REPLAY, see input_replay.h
+ *
+ * Generated by host/replay_gen from scenarios/engage.replay, do not edit.
+ */
+#ifndef REPLAY_SCRIPT_H
+#define REPLAY_SCRIPT_H
+
+#include "input_replay.h"
+
+#define REPLAY_SCRIPT_LENGTH 13
+
+static const replay_event replay_script[REPLAY_SCRIPT_LENGTH] = {
+  {      0, 0x8, 0x00003},
+  {   8000, 0x0, 0x00003},
+  {   9000, 0x2, 0x00003},
+  {   9100, 0x0, 0x00003},
+  {  40000, 0x4, 0x00003},
+  {  42000, 0x0, 0x00003},
+  {  45000, 0x2, 0x00003},
+  {  45100, 0x0, 0x00003},
+  {  47000, 0x2, 0x00003},
+  {  47100, 0x0, 0x00003},
+  {  60000, 0x0, 0x00203},
+  {  70000, 0x0, 0x00003},
+  {  90000, 0x0, 0x00000},
+};
+
+#endif /* REPLAY_SCRIPT_H */
@@ -0,0 +1,187 @@
+/* Per-task deadline and budget monitor, see task_monitor.h */
+#include <stdio.h>
+#include <string.h>
+#include "task_monitor.h"
+#include "cruise_clock.h"
+#include "cpu_account.h"
+
+typedef struct {
+  const char *name;
+  INT32U period;   /* [us] */
+  INT32U deadline; /* [us] */
+  INT32U budget;   /* [us], 0 = none */
+} tm_limits;
+
+#define TM_LIMITS(name, period, deadline, budget, crit, stack) \
+  {#name, (period) * 1000UL, (deadline) * 1000UL, budget},
+static tm_limits limits[TASK_COUNT] = { CRUISE_TASKS(TM_LIMITS) }; /* tm_set_period() */
+#undef TM_LIMITS
+
+static tm_stats stats[TASK_COUNT];
+static INT8U running[TASK_COUNT]; /* released and not finished */
+static INT8U pending[TASK_COUNT]; /* releases while running, not started yet */
+static INT32U pending_release[TASK_COUNT]; /* of the oldest of them [us] */
+static INT32U start_cycles[TASK_COUNT];    /* cpu_self_cycles() at the start */
+
+void tm_init(void)
+{
+  memset(running, 0, sizeof(running));
+  memset(pending, 0, sizeof(pending));
+  tm_reset();
+}
+
+void tm_reset(void)
+{
+  int i;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  for (i = 0; i < TASK_COUNT; i++) {
+    memset(&stats[i], 0, sizeof(stats[i]));
+    stats[i].resp_min = 0xffffffff;
+  }
+  OS_EXIT_CRITICAL();
+}
+
+void tm_release(INT8U task)
+{
+  tm_stats *s = &stats[task];
+
+  if (running[task] || pending[task]) {
+    /* the previous release keeps its release time, this one is queued */
+    if (pending[task] == 0)
+      pending_release[task] = cruise_clock_us();
+    if (pending[task] < 0xff)
+      pending[task]++;
+    s->backlog++;
+    return;
+  }
+  s->last_release = cruise_clock_us();
+  s->releases++;
+  running[task] = 1;
+}
+
+/*
+ * A start after the finish of a backlogged run is the oldest queued
+ * release; the ones queued after it were released a period apart.
+ */
+void tm_start(INT8U task)
+{
+  tm_stats *s = &stats[task];
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  if (!running[task] && pending[task]) {
+    s->last_release = pending_release[task];
+    s->releases++;
+    running[task] = 1;
+    pending[task]--;
+    pending_release[task] += limits[task].period;
+  }
+  s->last_start = cruise_clock_us();
+  OS_EXIT_CRITICAL();
+  start_cycles[task] = cpu_self_cycles();
+}
+
+void tm_set_period(INT8U task, INT16U period_ms, INT16U deadline_ms)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  limits[task].period = period_ms * 1000UL;
+  limits[task].deadline = deadline_ms * 1000UL;
+  OS_EXIT_CRITICAL();
+}
+
+/* The task dropped its queued releases (OSSemSet), they never start */
+void tm_drop(INT8U task)
+{
+  pending[task] = 0;
+}
+
+void tm_finish(INT8U task)
+{
+  tm_stats *s = &stats[task];
+  INT32U now = cruise_clock_us();
+  INT32U resp = now - s->last_release;
+  /* without the time of the tasks and ISRs that preempted it */
+  INT32U exec = (cpu_self_cycles() - start_cycles[task]) / (CRUISE_CLOCK_HZ / 1000000UL);
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  s->last_finish = now;
+  s->completions++;
+  if (resp > limits[task].deadline)
+    s->deadline_misses++;
+  if (limits[task].budget && exec > limits[task].budget)
+    s->budget_overruns++;
+  if (resp < s->resp_min)
+    s->resp_min = resp;
+  if (resp > s->resp_max)
+    s->resp_max = resp;
+  s->resp_sum += resp;
+  if (exec > s->exec_max)
+    s->exec_max = exec;
+  running[task] = 0;
+  OS_EXIT_CRITICAL();
+}
+
+int tm_get(INT8U task, tm_stats *out)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  if (task >= TASK_COUNT)
+    return -1;
+  OS_ENTER_CRITICAL();
+  *out = stats[task];
+  OS_EXIT_CRITICAL();
+  return 0;
+}
+
+INT32U tm_misses(void)
+{
+  INT32U n = 0;
+  int i;
+
+  for (i = 0; i < TASK_COUNT; i++)
+    n += stats[i].deadline_misses;
+  return n;
+}
+
+INT32U tm_overruns(void)
+{
+  INT32U n = 0;
+  int i;
+
+  for (i = 0; i < TASK_COUNT; i++)
+    n += stats[i].budget_overruns;
+  return n;
+}
+
+void tm_print_summary(void)
+{
+  tm_stats s;
+  int i;
+
+  printf("%-18s %7s %5s %5s %5s %8s %8s %8s %8s\n", "task", "runs", "miss", "over",
+         "back", "resp_min", "resp_avg", "resp_max", "exec_max");
+  for (i = 0; i < TASK_COUNT; i++) {
+    tm_get(i, &s);
+    printf("%-18s %7lu %5lu %5lu %5lu %8lu %8lu %8lu %8lu\n", limits[i].name,
+           (unsigned long)s.completions, (unsigned long)s.deadline_misses,
+           (unsigned long)s.budget_overruns, (unsigned long)s.backlog,
+           (unsigned long)(s.completions ? s.resp_min : 0),
+           (unsigned long)(s.completions ? s.resp_sum / s.completions : 0),
+           (unsigned long)s.resp_max, (unsigned long)s.exec_max);
+  }
+}
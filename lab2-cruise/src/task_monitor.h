@@ -0,0 +1,65 @@
+/* Per-task deadline and budget monitor
+ *
+ * Description:
+ *
+ *   Records for every task of CRUISE_TASKS when it was released, started
+ *   and finished, on the cruise_clock time base:
+ *
+ *     response time  = finish - release, a deadline miss if it exceeds the
+ *                      deadline of the task table,
+ *     execution time = CPU time of the task from start to finish, a
+ *                      budget overrun if it exceeds the budget of the task
+ *                      table. Preemption by higher priority tasks and the
+ *                      accounted ISRs is not included (cpu_self_cycles(),
+ *                      needs the switch hook of cpu_account.h).
+ *
+ *   tm_set_period() replaces the period and deadline of the task table
+ *   for a task whose rate changes at run time (ADAPTIVE_RATE).
+ *
+ *   A release while the previous one has not finished yet is counted as
+ *   backlog and queued, so the run that serves it later is measured from
+ *   its own release time. All counters are 32 bit and statically allocated;
+ *   tm_reset() starts a new observation window.
+ *
+ *   The hooks are cheap (one clock read and a few compares) and may be
+ *   called from an ISR (tm_release) or the task itself (tm_start,
+ *   tm_finish).
+ */
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include "cruise_types.h"
+#include "cruise_tasks.h"
+
+typedef struct {
+  INT32U releases;
+  INT32U completions;
+  INT32U deadline_misses;
+  INT32U budget_overruns;
+  INT32U backlog;          /* releases while still running */
+  INT32U last_release;     /* [us] */
+  INT32U last_start;
+  INT32U last_finish;
+  INT32U resp_min;         /* response time [us] */
+  INT32U resp_max;
+  INT64U resp_sum;         /* 32 bit would wrap within hours */
+  INT32U exec_max;         /* execution time [us] */
+} tm_stats;
+
+void tm_init(void);
+void tm_reset(void);
+
+void tm_release(INT8U task);
+void tm_start(INT8U task);
+void tm_finish(INT8U task);
+void tm_drop(INT8U task);
+void tm_set_period(INT8U task, INT16U period_ms, INT16U deadline_ms);
+
+/* Copies the statistics of 'task'; returns 0, or -1 for an invalid id */
+int tm_get(INT8U task, tm_stats *stats);
+/* Deadline misses and budget overruns of all tasks since tm_reset() */
+INT32U tm_misses(void);
+INT32U tm_overruns(void);
+void tm_print_summary(void);
+
+#endif /* TASK_MONITOR_H */
@@ -0,0 +1,235 @@
+/* Telemetry recorder, see telemetry.h */
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+
+static INT8U ring[TEL_RING_SIZE][TEL_RECORD_SIZE];
+static INT32U head, tail;  /* records put / sent, head - tail <= TEL_RING_SIZE */
+static INT8U seq;
+static int use_delta;
+static tel_record last;    /* last record sent */
+static int last_valid;     /* 'last' is the record before the next one */
+static INT16U since_key;
+static INT32U dropped, sent, bytes;
+
+void tel_init(int delta)
+{
+  head = tail = 0;
+  seq = 0;
+  use_delta = delta;
+  last_valid = 0;
+  since_key = 0;
+  dropped = sent = bytes = 0;
+}
+
+static void put16(INT8U *p, INT16U v)
+{
+  p[0] = (INT8U)v;
+  p[1] = (INT8U)(v >> 8);
+}
+
+static void put32(INT8U *p, INT32U v)
+{
+  put16(p, (INT16U)v);
+  put16(p + 2, (INT16U)(v >> 16));
+}
+
+static INT16U get16(const INT8U *p)
+{
+  return (INT16U)(p[0] | p[1] << 8);
+}
+
+static INT32U get32(const INT8U *p)
+{
+  return get16(p) | (INT32U)get16(p + 2) << 16;
+}
+
+void tel_pack(const tel_record *r, INT8U *buf)
+{
+  buf[0] = r->seq;
+  buf[1] = r->flags;
+  buf[2] = r->throttle;
+  buf[3] = r->target;
+  put32(buf + 4, r->time);
+  put32(buf + 8, r->position);
+  put16(buf + 12, (INT16U)r->velocity);
+  put16(buf + 14, (INT16U)r->acceleration);
+}
+
+void tel_unpack(const INT8U *buf, tel_record *r)
+{
+  r->seq = buf[0];
+  r->flags = buf[1];
+  r->throttle = buf[2];
+  r->target = buf[3];
+  r->time = get32(buf + 4);
+  r->position = get32(buf + 8);
+  r->velocity = (INT16S)get16(buf + 12);
+  r->acceleration = (INT16S)get16(buf + 14);
+}
+
+void tel_put(tel_record *r)
+{
+  INT8U buf[TEL_RECORD_SIZE];
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  r->seq = seq++;
+  tel_pack(r, buf);
+  OS_ENTER_CRITICAL();
+  if (head - tail == TEL_RING_SIZE) {
+    tail++;
+    dropped++;
+  }
+  memcpy(ring[head % TEL_RING_SIZE], buf, TEL_RECORD_SIZE);
+  head++;
+  OS_EXIT_CRITICAL();
+}
+
+static INT8U check(const INT8U *buf, INT16U len)
+{
+  INT8U sum = 0;
+
+  while (len--)
+    sum += *buf++;
+  return (INT8U)~sum;
+}
+
+static INT16U put_varint(INT8U *p, INT32S v)
+{
+  INT32U z = ((INT32U)v << 1) ^ (INT32U)(v >> 31); /* zigzag */
+  INT16U n = 0;
+
+  while (z >= 0x80) {
+    p[n++] = (INT8U)(z | 0x80);
+    z >>= 7;
+  }
+  p[n++] = (INT8U)z;
+  return n;
+}
+
+INT16U tel_encode(const tel_record *r, const tel_record *prev, INT8U *buf)
+{
+  INT16U n;
+
+  if (prev == NULL) {
+    buf[0] = TEL_KEY;
+    tel_pack(r, buf + 1);
+    n = 1 + TEL_RECORD_SIZE;
+  } else {
+    buf[0] = TEL_DELTA;
+    buf[1] = r->flags;
+    buf[2] = r->throttle;
+    buf[3] = r->target;
+    n = 4;
+    n += put_varint(buf + n, (INT32S)(r->time - prev->time));
+    n += put_varint(buf + n, (INT32S)(r->position - prev->position));
+    n += put_varint(buf + n, r->velocity - prev->velocity);
+    n += put_varint(buf + n, r->acceleration - prev->acceleration);
+  }
+  buf[n] = check(buf, n);
+  return n + 1;
+}
+
+INT16U tel_flush(tel_write_fn write, INT16U max)
+{
+  INT8U rec[TEL_RECORD_SIZE], frame[TEL_FRAME_MAX];
+  tel_record r;
+  INT16U n, done = 0;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  while (done < max) {
+    OS_ENTER_CRITICAL();
+    if (tail == head) {
+      OS_EXIT_CRITICAL();
+      break;
+    }
+    memcpy(rec, ring[tail % TEL_RING_SIZE], TEL_RECORD_SIZE);
+    tail++;
+    OS_EXIT_CRITICAL();
+
+    tel_unpack(rec, &r);
+    if (!use_delta || !last_valid || r.seq != (INT8U)(last.seq + 1) || since_key >= TEL_KEYFRAME) {
+      n = tel_encode(&r, NULL, frame);
+      since_key = 0;
+    } else {
+      n = tel_encode(&r, &last, frame);
+    }
+    since_key++;
+    write(frame, n);
+    last = r;
+    last_valid = 1;
+    bytes += n;
+    sent++;
+    done++;
+  }
+  return done;
+}
+
+void tel_print_stats(void)
+{
+  printf("telemetry: %lu sent, %lu dropped, %lu bytes (%lu per record)\n", (unsigned long)sent,
+         (unsigned long)dropped, (unsigned long)bytes, (unsigned long)(sent ? bytes / sent : 0));
+}
+
+static int get_varint(const INT8U *buf, int len, int *pos, INT32S *v)
+{
+  INT32U z = 0;
+  int shift = 0;
+
+  for (;;) {
+    if (*pos >= len)
+      return 0;
+    z |= (INT32U)(buf[*pos] & 0x7f) << shift;
+    if (!(buf[(*pos)++] & 0x80))
+      break;
+    shift += 7;
+    if (shift > 28)
+      return -1;
+  }
+  *v = (INT32S)(z >> 1) ^ -(INT32S)(z & 1);
+  return 1;
+}
+
+int tel_decode(const INT8U *buf, int len, const tel_record *prev, tel_record *r)
+{
+  INT32S d[4];
+  int pos, i, ok;
+
+  if (len < 1)
+    return 0;
+  if (buf[0] == TEL_KEY) {
+    if (len < TEL_RECORD_SIZE + 2)
+      return 0;
+    if (buf[TEL_RECORD_SIZE + 1] != check(buf, TEL_RECORD_SIZE + 1))
+      return -1;
+    tel_unpack(buf + 1, r);
+    return TEL_RECORD_SIZE + 2;
+  }
+  if (buf[0] != TEL_DELTA || prev == NULL)
+    return -1;
+  if (len < 4)
+    return 0;
+  pos = 4;
+  for (i = 0; i < 4; i++) {
+    ok = get_varint(buf, len, &pos, &d[i]);
+    if (ok <= 0)
+      return ok;
+  }
+  if (pos >= len)
+    return 0;
+  if (buf[pos] != check(buf, (INT16U)pos))
+    return -1;
+  r->seq = (INT8U)(prev->seq + 1);
+  r->flags = buf[1];
+  r->throttle = buf[2];
+  r->target = buf[3];
+  r->time = prev->time + (INT32U)d[0];
+  r->position = prev->position + (INT32U)d[1];
+  r->velocity = (INT16S)(prev->velocity + d[2]);
+  r->acceleration = (INT16S)(prev->acceleration + d[3]);
+  return pos + 1;
+}
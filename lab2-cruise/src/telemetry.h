@@ -0,0 +1,79 @@
+/* Telemetry recorder
+ *
+ * Description:
+ *
+ *   VehicleTask records the state of the car once per period into a ring
+ *   buffer in RAM, as fixed-width records of TEL_RECORD_SIZE bytes (little
+ *   endian, see tel_pack()). When the ring is full the oldest record is
+ *   dropped, so the ring always holds the last TEL_RING_SIZE periods for a
+ *   post-mortem, e.g. read with the debugger.
+ *
+ *   tel_flush(), called from a low priority task, streams the records that
+ *   have not been sent yet as frames:
+ *
+ *     key    0xA5, record (TEL_RECORD_SIZE bytes), check
+ *     delta  0x5A, flags, throttle, target, then the differences of time,
+ *            position, velocity and acceleration to the previous record as
+ *            zigzag varints (7 bits per byte, lowest first), check
+ *
+ *   'check' is the complement of the 8 bit sum of the frame bytes before
+ *   it. Deltas (tel_init(1)) are only sent for the record right after the
+ *   previous one; after a dropped record and every TEL_KEYFRAME records a
+ *   key frame is sent. The frames may be interleaved with other output on
+ *   the same channel: tel_decode() skips what does not check out and waits
+ *   for the next key frame. host/tel_decode.c turns a stream into CSV.
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "cruise_types.h"
+
+#define TEL_RECORD_SIZE 16
+#define TEL_RING_SIZE   256  /* records, a power of two */
+#define TEL_KEYFRAME    32   /* records */
+#define TEL_FRAME_MAX   (TEL_RECORD_SIZE + 2) /* longest frame */
+
+#define TEL_KEY   0xA5
+#define TEL_DELTA 0x5A
+
+/* flags */
+#define TEL_ENGINE   0x01
+#define TEL_TOP_GEAR 0x02
+#define TEL_BRAKE    0x04
+#define TEL_GAS      0x08
+#define TEL_CRUISE   0x10  /* cruise control button toggled on */
+#define TEL_CRUISING 0x20  /* controller holds the target */
+#define TEL_DEGRADED 0x40  /* see cruise_mode.h */
+
+typedef struct {
+  INT8U  seq;           /* record number, set by tel_put() */
+  INT8U  flags;
+  INT8U  throttle;      /* 0..80 */
+  INT8U  target;        /* [m/s] */
+  INT32U time;          /* cruise_clock_us(), wraps */
+  INT32U position;      /* [cm] */
+  INT16S velocity;      /* Q7.8 [m/s] */
+  INT16S acceleration;  /* Q7.8 [m/s^2] */
+} tel_record;
+
+typedef void (*tel_write_fn)(const INT8U *buf, INT16U len);
+
+void tel_init(int delta);
+void tel_put(tel_record *r);
+/* Sends up to 'max' records, returns how many */
+INT16U tel_flush(tel_write_fn write, INT16U max);
+void tel_print_stats(void);
+
+void tel_pack(const tel_record *r, INT8U *buf);
+void tel_unpack(const INT8U *buf, tel_record *r);
+INT16U tel_encode(const tel_record *r, const tel_record *prev, INT8U *buf);
+
+/*
+ * Decodes the frame at the start of 'buf' ('len' bytes). 'prev' is the
+ * previous record decoded, or NULL. Returns the length of the frame and
+ * sets 'r', 0 if 'buf' ends within the frame, or -1 if no frame starts at
+ * 'buf' (skip one byte and try again).
+ */
+int tel_decode(const INT8U *buf, int len, const tel_record *prev, tel_record *r);
+
+#endif /* TELEMETRY_H */
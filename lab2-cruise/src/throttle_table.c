@@ -0,0 +1,16 @@
+/* Throttle gain schedules, see throttle_table.h */
+#include "throttle_table.h"
+
+#define VELOCITY_CUR(i) GS_PICK(i, -5, 10, 20, 30, 40, 50, 60, 70, 80)
+#define SPEED_UP(i)     GS_PICK(i, 30, 30, 40, 50, 70, 70, 80, 80, 70)
+#define SLOW_DOWN(i)    GS_PICK(i,  5,  5, 10, 20, 30, 40, 50, 60, 70)
+
+#define SPEED_UP_ENTRY(k)  GS_ENTRY(k, VELOCITY_CUR, SPEED_UP),
+#define SLOW_DOWN_ENTRY(k) GS_ENTRY(k, VELOCITY_CUR, SLOW_DOWN),
+
+/* -5..80 m/s are 86 entries, the remaining ones saturate */
+static const INT16S speed_up_y[]  = { GS_REP128(SPEED_UP_ENTRY, 0) };
+static const INT16S slow_down_y[] = { GS_REP128(SLOW_DOWN_ENTRY, 0) };
+
+const gain_table throttle_speed_up  = GS_TABLE(VELOCITY_CUR, speed_up_y);
+const gain_table throttle_slow_down = GS_TABLE(VELOCITY_CUR, slow_down_y);
@@ -0,0 +1,18 @@
+/* Throttle gain schedules used outside of cruise mode
+ *
+ * Description:
+ *
+ *   Throttle (Q8, 0..80) as a function of the velocity while the gas pedal is
+ *   pressed (throttle_speed_up) or released (throttle_slow_down). The
+ *   schedules are defined by breakpoints every 10 m/s between -5 and 80 m/s
+ *   and saturate outside of that range.
+ */
+#ifndef THROTTLE_TABLE_H
+#define THROTTLE_TABLE_H
+
+#include "gain_table.h"
+
+extern const gain_table throttle_speed_up;
+extern const gain_table throttle_slow_down;
+
+#endif /* THROTTLE_TABLE_H */
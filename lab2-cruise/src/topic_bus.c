@@ -0,0 +1,199 @@
+/* Publish/subscribe topic bus, see topic_bus.h */
+#include <stdio.h>
+#include <string.h>
+#include "topic_bus.h"
+#include "cruise_clock.h"
+
+typedef struct {
+  const char *name;
+  INT8U       size;
+  INT8U       subscribers;
+  INT32U      seq;    /* number of samples ever published, 0 = empty */
+  INT32U      stamp;  /* publish time of the current sample [us] */
+  trace_tag   tag;    /* of the current sample, see e2e_trace.h */
+  INT32U      data[(TOPIC_MAX_SIZE + 3) / 4];
+  /* statistics */
+  INT32U      publishes;
+  INT32U      deliveries;
+  INT32U      lat_min;
+  INT32U      lat_max;
+  INT32U      lat_sum;
+  INT32U      window_start;
+} topic;
+
+#define TOPIC_INIT(id, name, size) {name, size},
+static topic topics[TOPIC_COUNT] = {
+  CRUISE_TOPICS(TOPIC_INIT)
+};
+#undef TOPIC_INIT
+
+/* Every payload has to fit into the sample buffer of its topic */
+#define TOPIC_SIZE_CHECK(id, name, size) typedef char id##_fits[(size) <= TOPIC_MAX_SIZE ? 1 : -1];
+CRUISE_TOPICS(TOPIC_SIZE_CHECK)
+#undef TOPIC_SIZE_CHECK
+
+static void reset_stats(topic *t, INT32U now)
+{
+  t->publishes = 0;
+  t->deliveries = 0;
+  t->lat_min = 0xffffffff;
+  t->lat_max = 0;
+  t->lat_sum = 0;
+  t->window_start = now;
+}
+
+void topic_bus_init(void)
+{
+  INT32U now = cruise_clock_us();
+  int i;
+
+  for (i = 0; i < TOPIC_COUNT; i++) {
+    topics[i].subscribers = 0;
+    topics[i].seq = 0;
+    reset_stats(&topics[i], now);
+  }
+}
+
+INT8U topic_subscribe(topic_sub *sub, INT8U id)
+{
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  if (id >= TOPIC_COUNT) {
+    return TOPIC_ERR_ID;
+  }
+  sub->topic = id;
+  sub->seen = 0;
+  OS_ENTER_CRITICAL();
+  topics[id].subscribers++;
+  OS_EXIT_CRITICAL();
+  return OS_ERR_NONE;
+}
+
+/*
+ * Copies the sample into the topic. The cost is the same no matter how
+ * many tasks have subscribed to the topic.
+ */
+void topic_publish(INT8U id, const void *msg)
+{
+  topic_publish_traced(id, msg, NULL);
+}
+
+/* Same, with the trace tag of the sample (NULL: untraced) */
+void topic_publish_traced(INT8U id, const void *msg, const trace_tag *tag)
+{
+  topic *t = &topics[id];
+  INT32U now = cruise_clock_us();
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  memcpy(t->data, msg, t->size);
+  if (tag != NULL)
+    t->tag = *tag;
+  else
+    t->tag.id = 0;
+  t->stamp = now;
+  t->seq++;
+  t->publishes++;
+  OS_EXIT_CRITICAL();
+}
+
+/*
+ * Copies the latest sample of the subscribed topic into 'msg' if it has not
+ * been read by this subscriber yet. Returns OS_ERR_NONE in that case and
+ * TOPIC_ERR_NO_NEW (leaving 'msg' untouched) otherwise.
+ */
+INT8U topic_read(topic_sub *sub, void *msg)
+{
+  return topic_read_traced(sub, msg, NULL);
+}
+
+/* Same, also copies the trace tag of the sample into 'tag' unless NULL */
+INT8U topic_read_traced(topic_sub *sub, void *msg, trace_tag *tag)
+{
+  topic *t = &topics[sub->topic];
+  INT32U now, latency;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  if (t->seq == sub->seen) {
+    return TOPIC_ERR_NO_NEW;
+  }
+
+  /* inside, so a publish cannot stamp the sample after 'now' */
+  OS_ENTER_CRITICAL();
+  now = cruise_clock_us();
+  memcpy(msg, t->data, t->size);
+  if (tag != NULL)
+    *tag = t->tag;
+  sub->seen = t->seq;
+  latency = now - t->stamp;
+  t->deliveries++;
+  t->lat_sum += latency;
+  if (latency < t->lat_min)
+    t->lat_min = latency;
+  if (latency > t->lat_max)
+    t->lat_max = latency;
+  OS_EXIT_CRITICAL();
+
+  return OS_ERR_NONE;
+}
+
+void topic_get_stats(INT8U id, topic_stats *stats)
+{
+  topic *t = &topics[id];
+  INT32U now = cruise_clock_us();
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  OS_ENTER_CRITICAL();
+  stats->publishes = t->publishes;
+  stats->deliveries = t->deliveries;
+  stats->lat_min = t->deliveries ? t->lat_min : 0;
+  stats->lat_max = t->lat_max;
+  stats->lat_sum = t->lat_sum;
+  stats->window_us = now - t->window_start;
+  stats->subscribers = t->subscribers;
+  OS_EXIT_CRITICAL();
+}
+
+void topic_reset_stats(void)
+{
+  INT32U now = cruise_clock_us();
+  int i;
+#if OS_CRITICAL_METHOD == 3
+  OS_CPU_SR cpu_sr = 0;
+#endif
+
+  for (i = 0; i < TOPIC_COUNT; i++) {
+    OS_ENTER_CRITICAL();
+    reset_stats(&topics[i], now);
+    OS_EXIT_CRITICAL();
+  }
+}
+
+/*
+ * Prints rate and latency of every topic since the last reset and starts a
+ * new counting window.
+ */
+void topic_print_stats(void)
+{
+  topic_stats s;
+  int i;
+
+  printf("topic        subs  rate[1/s]  lat min/avg/max [us]\n");
+  for (i = 0; i < TOPIC_COUNT; i++) {
+    topic_get_stats(i, &s);
+    printf("%-12s %4u %10lu  %lu/%lu/%lu\n", topics[i].name, s.subscribers,
+        s.window_us ? (unsigned long)((unsigned long long)s.publishes * 1000000 / s.window_us) : 0UL,
+        (unsigned long)s.lat_min,
+        s.deliveries ? (unsigned long)(s.lat_sum / s.deliveries) : 0UL,
+        (unsigned long)s.lat_max);
+  }
+  topic_reset_stats();
+}
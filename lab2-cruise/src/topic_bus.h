@@ -0,0 +1,62 @@
+/* Publish/subscribe topic bus
+ *
+ * Description:
+ *
+ *   A mailbox of uC/OS-II has exactly one consumer, so a signal that is
+ *   needed by several tasks has to be posted once per consumer. A topic
+ *   instead keeps the latest sample of a signal together with a sequence
+ *   number. Publishing copies the sample once into the topic, independent of
+ *   the number of subscribers, and every subscriber remembers the sequence
+ *   number of the last sample it has read.
+ *
+ *   Topics are declared statically in cruise_topics.h. Subscribers register
+ *   with topic_subscribe() before entering their task loop and poll with
+ *   topic_read() whenever they are released.
+ *
+ *   For each topic the bus counts publishes and fresh deliveries, and the
+ *   latency from publish to the first read of a sample by each subscriber.
+ */
+#ifndef TOPIC_BUS_H
+#define TOPIC_BUS_H
+
+#include "cruise_topics.h"
+#include "e2e_trace.h"
+
+#define TOPIC_MAX_SIZE 8 /* largest payload in bytes */
+
+#define TOPIC_ERR_NO_NEW 1 /* topic_read(): no sample newer than the last one read */
+#define TOPIC_ERR_ID     2 /* unknown topic identifier */
+
+#define TOPIC_ENUM(id, name, size) id,
+enum topic_id {
+  CRUISE_TOPICS(TOPIC_ENUM)
+  TOPIC_COUNT
+};
+#undef TOPIC_ENUM
+
+typedef struct {
+  INT8U  topic; /* topic identifier */
+  INT32U seen;  /* sequence number of the last sample read */
+} topic_sub;
+
+typedef struct {
+  INT32U publishes;   /* samples published since the last reset */
+  INT32U deliveries;  /* fresh samples read by subscribers since the last reset */
+  INT32U lat_min;     /* publish to read latency [us] */
+  INT32U lat_max;
+  INT32U lat_sum;
+  INT32U window_us;   /* length of the counting window [us] */
+  INT8U  subscribers;
+} topic_stats;
+
+void  topic_bus_init(void);
+INT8U topic_subscribe(topic_sub *sub, INT8U topic);
+void  topic_publish(INT8U topic, const void *msg);
+void  topic_publish_traced(INT8U topic, const void *msg, const trace_tag *tag);
+INT8U topic_read(topic_sub *sub, void *msg);
+INT8U topic_read_traced(topic_sub *sub, void *msg, trace_tag *tag);
+void  topic_get_stats(INT8U topic, topic_stats *stats);
+void  topic_reset_stats(void);
+void  topic_print_stats(void);
+
+#endif /* TOPIC_BUS_H */
@@ -0,0 +1,137 @@
+/* Track profile, see track.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track.h"
+
+/* constant that should not be modified */
+#define GRAVITY_FACTOR 2
+
+const track_segment track_loop_segments[TRACK_LOOP_SEGMENTS] = {
+  {400, TRACK_SLOPE(0),                   17},
+  {400, TRACK_SLOPE(-GRAVITY_FACTOR),     16}, // traveling uphill
+  {400, TRACK_SLOPE(-2 * GRAVITY_FACTOR), 15}, // traveling steep uphill
+  {400, TRACK_SLOPE(0),                   14},
+  {400, TRACK_SLOPE(2 * GRAVITY_FACTOR),  13}, // traveling downhill
+  {400, TRACK_SLOPE(GRAVITY_FACTOR),      12}, // traveling steep downhill
+};
+
+/* uniform, so the segment starts are not needed */
+const track track_loop = {track_loop_segments, TRACK_LOOP_SEGMENTS, 2400, 400, {0}};
+
+int track_init(track *t, const track_segment *segments, INT16U n)
+{
+  INT32U length = 0;
+  INT16U i;
+
+  if (n == 0 || n > TRACK_MAX_SEGMENTS)
+    return -1;
+  t->grid = segments[0].length;
+  for (i = 0; i < n; i++) {
+    if (segments[i].length == 0 || length + segments[i].length < length)
+      return -1;
+    if (segments[i].length != t->grid)
+      t->grid = 0;
+    t->start[i] = length;
+    length += segments[i].length;
+  }
+  t->segment = segments;
+  t->n = n;
+  t->length = length;
+  return 0;
+}
+
+INT16U track_index(const track *t, INT32U position)
+{
+  INT16U lo = 0, hi = t->n, mid;
+
+  if (position >= t->length)
+    position %= t->length;
+  if (t->grid)
+    return (INT16U)(position / t->grid);
+
+  /* last segment starting at or before 'position' */
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    if (t->start[mid] <= position)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+INT32S track_slope(const track *t, INT32U position)
+{
+  return t->segment[track_index(t, position)].slope;
+}
+
+INT32U track_led(const track *t, INT32U position)
+{
+  INT8S led = t->segment[track_index(t, position)].led;
+
+  return led < 0 ? 0 : 1UL << led;
+}
+
+#ifdef CRUISE_HOST
+int track_load(const char *path, track_segment *segments, int max)
+{
+  FILE *f = fopen(path, "r");
+  char line[256], *p, *end;
+  int n = 0, lineno = 0, led, error = 0;
+  unsigned long length;
+  double slope;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    if ((p = strchr(line, '#')) != NULL)
+      *p = '\0';
+    p = line;
+    length = strtoul(p, &end, 10);
+    if (end == p) {
+      while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+      if (*p == '\0')
+        continue;
+      error = 1;
+      break;
+    }
+    p = end;
+    slope = strtod(p, &end);
+    if (end == p) {
+      error = 1;
+      break;
+    }
+    p = end;
+    led = (int)strtol(p, &end, 10);
+    if (end == p)
+      led = TRACK_NO_LED;
+    p = end;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+      p++;
+    if (*p != '\0' || length == 0 || led < TRACK_NO_LED || led > 17) {
+      error = 1;
+      break;
+    }
+    if (n == max) {
+      fprintf(stderr, "%s:%d: more than %d segments\n", path, lineno, max);
+      fclose(f);
+      return -1;
+    }
+    segments[n].length = (INT32U)length;
+    segments[n].slope = (INT32S)(slope * 65536.0 + (slope < 0 ? -0.5 : 0.5));
+    segments[n].led = (INT8S)led;
+    n++;
+  }
+  if (error) {
+    fprintf(stderr, "%s:%d: syntax error\n", path, lineno);
+    n = -1;
+  }
+  fclose(f);
+  return n;
+}
+#endif
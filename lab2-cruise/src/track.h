@@ -0,0 +1,69 @@
+/* Track profile
+ *
+ * Description:
+ *
+ *   A track is a loop of segments, each with a length, a slope and the red
+ *   LED that shows the vehicle is on it. The slope is given as the
+ *   acceleration by gravity along the track, Q15.16 like the vehicle model
+ *   [m/s^2], negative uphill.
+ *
+ *   track_init() checks a segment table and prepares the lookup: if all
+ *   segments have the same length the segment of a position is found by
+ *   one division, otherwise by a binary search over the segment starts.
+ *   Positions are 32 bit [m], so a track can be any length up to the
+ *   range of the vehicle model; positions past the end wrap around.
+ *
+ *   track_loop is the 2400 m loop of the lab, in six segments of 400 m
+ *   shown on LEDR17..LEDR12, ready to use without track_init(). On the
+ *   host, track_load() reads a track from a file with one segment per
+ *   line:
+ *
+ *     <length m> <slope m/s^2> [<LED>]
+ *
+ *   '#' starts a comment, a segment without LED lights none.
+ */
+#ifndef TRACK_H
+#define TRACK_H
+
+#include "cruise_types.h"
+
+#ifdef CRUISE_HOST
+#define TRACK_MAX_SEGMENTS 8192
+#else
+#define TRACK_MAX_SEGMENTS 256
+#endif
+
+#define TRACK_NO_LED -1
+#define TRACK_SLOPE(x) ((INT32S)((x) * 65536L)) /* [m/s^2] to Q15.16 */
+
+typedef struct {
+  INT32U length;  /* [m] */
+  INT32S slope;   /* Q15.16 [m/s^2] */
+  INT8S  led;     /* LEDR number or TRACK_NO_LED */
+} track_segment;
+
+typedef struct {
+  const track_segment *segment;
+  INT16U n;
+  INT32U length;                     /* [m] */
+  INT32U grid;                       /* length of every segment, 0 if they differ */
+  INT32U start[TRACK_MAX_SEGMENTS];  /* [m], for the binary search */
+} track;
+
+#define TRACK_LOOP_SEGMENTS 6
+extern const track_segment track_loop_segments[TRACK_LOOP_SEGMENTS];
+extern const track track_loop;
+
+/* Returns 0, or -1 for an empty, too long or too large table */
+int    track_init(track *t, const track_segment *segments, INT16U n);
+INT16U track_index(const track *t, INT32U position);
+INT32S track_slope(const track *t, INT32U position);
+/* Bit of the LED of the segment at 'position', 0 for none */
+INT32U track_led(const track *t, INT32U position);
+
+#ifdef CRUISE_HOST
+/* Reads a track file, returns the number of segments or -1 */
+int track_load(const char *path, track_segment *segments, int max);
+#endif
+
+#endif /* TRACK_H */
@@ -0,0 +1,89 @@
+/* Fixed-point model of the vehicle, see vehicle_model.h */
+#include "vehicle_model.h"
+
+/* (a * b) >> shift with a 64 bit intermediate, rounded to nearest */
+static INT64S mul_shift(INT32S a, INT32S b, int shift)
+{
+  INT64S p = (INT64S)a * b;
+
+  return (p + ((INT64S)1 << (shift - 1))) >> shift;
+}
+
+void vm_init(vehicle_state *vs, INT16U period_ms)
+{
+  vs->position = 0;
+  vs->velocity = 0;
+  vs->acceleration = 0;
+  vs->track = &track_loop;
+  vm_set_period(vs, period_ms);
+}
+
+/*
+ * The step length is converted once to seconds in Q7.24, so that vm_step()
+ * only multiplies.
+ */
+void vm_set_period(vehicle_state *vs, INT16U period_ms)
+{
+  vs->period = period_ms;
+  vs->dt = (INT32S)((((INT64S)period_ms << VM_DT_FRAC_BITS) + 500) / 1000);
+}
+
+/*
+ * The position is kept, wrapped to the length of the new track
+ */
+void vm_set_track(vehicle_state *vs, const track *t)
+{
+  vs->track = t;
+  vs->position %= VM_POS_FROM_INT(t->length);
+}
+
+void vm_step(vehicle_state *vs, INT8U throttle, enum active engine, enum active brake_pedal)
+{
+  const INT64S length = VM_POS_FROM_INT(vs->track->length);
+  INT32S acceleration;
+
+  if (throttle > VM_MAX_THROTTLE)
+    throttle = VM_MAX_THROTTLE;
+
+  // brakes + wind
+  if (brake_pedal == off) {
+    // wind resistance
+    acceleration = - VM_WIND_FACTOR * vs->velocity;
+    // actuate with engines
+    if (engine == on)
+      acceleration += VM_FROM_INT(throttle);
+    // gravity effects
+    acceleration += track_slope(vs->track, vm_position(vs));
+  }
+  // if the engine and the brakes are activated at the same time,
+  // we assume that the brake dynamics dominates, so both cases fall
+  // here.
+  else
+    acceleration = - VM_BRAKE_FACTOR * vs->velocity;
+
+  vs->acceleration = acceleration;
+  vs->position += mul_shift(vs->velocity, vs->dt, VM_FRAC_BITS + VM_DT_FRAC_BITS - VM_POS_FRAC_BITS);
+  vs->velocity += (INT32S)mul_shift(acceleration, vs->dt, VM_DT_FRAC_BITS);
+
+  // the track is a loop, in both directions
+  if (vs->position >= length)
+    vs->position -= length;
+  else if (vs->position < 0)
+    vs->position += length;
+}
+
+/*
+ * Velocity rounded to whole m/s
+ */
+INT16S vm_velocity(const vehicle_state *vs)
+{
+  return (INT16S)((vs->velocity + VM_ONE / 2) >> VM_FRAC_BITS);
+}
+
+/*
+ * Position truncated to whole metres
+ */
+INT32U vm_position(const vehicle_state *vs)
+{
+  return (INT32U)(vs->position >> VM_POS_FRAC_BITS);
+}
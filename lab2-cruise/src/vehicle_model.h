@@ -0,0 +1,59 @@
+/* Fixed-point model of the vehicle
+ *
+ * Description:
+ *
+ *   The car is a moving mass with linear resistances acting upon it (wind,
+ *   brakes) plus the throttle and the gravity of the track. The state is kept
+ *   in fixed point so that the model needs neither the software floating
+ *   point emulation of the Nios II nor an integer velocity that is truncated
+ *   at every step:
+ *
+ *     velocity, acceleration  Q15.16  [m/s], [m/s^2]
+ *     position                Q31.32  [m], 64 bit
+ *     step length             Q7.24   [s]
+ *
+ *   vm_step() advances the model by one period with explicit Euler
+ *   integration, like the original VehicleTask: the position is integrated
+ *   with the velocity at the beginning of the step.
+ *
+ *   The slope comes from a track profile (track.h), track_loop unless
+ *   vm_set_track() selects another one. The track is a loop, the position
+ *   wraps at its length.
+ */
+#ifndef VEHICLE_MODEL_H
+#define VEHICLE_MODEL_H
+
+#include "cruise_types.h"
+#include "track.h"
+
+#define VM_FRAC_BITS     16 /* velocity and acceleration */
+#define VM_POS_FRAC_BITS 32 /* position, fine enough not to drift at constant speed */
+#define VM_DT_FRAC_BITS  24 /* step length, keeps the rounding of e.g. 0.3 s below 1e-7 */
+
+#define VM_ONE              (1L << VM_FRAC_BITS)
+#define VM_FROM_INT(x)      ((INT32S)(x) * VM_ONE)
+#define VM_POS_FROM_INT(x)  ((INT64S)(x) << VM_POS_FRAC_BITS)
+
+#define VM_MAX_THROTTLE 80   /* the vehicle cannot effort more than 80 units of throttle */
+
+/* constants that should not be modified */
+#define VM_WIND_FACTOR  1
+#define VM_BRAKE_FACTOR 4
+
+typedef struct {
+  INT64S position;      /* Q31.32 [m] */
+  INT32S velocity;      /* Q15.16 [m/s] */
+  INT32S acceleration;  /* Q15.16 [m/s^2] */
+  INT16U period;        /* step length [ms] */
+  INT32S dt;            /* step length Q7.24 [s] */
+  const track *track;
+} vehicle_state;
+
+void   vm_init(vehicle_state *vs, INT16U period_ms);
+void   vm_set_period(vehicle_state *vs, INT16U period_ms);
+void   vm_set_track(vehicle_state *vs, const track *t);
+void   vm_step(vehicle_state *vs, INT8U throttle, enum active engine, enum active brake_pedal);
+INT16S vm_velocity(const vehicle_state *vs);
+INT32U vm_position(const vehicle_state *vs);
+
+#endif /* VEHICLE_MODEL_H */